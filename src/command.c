@@ -46,6 +46,10 @@
 #include "traceswo.h"
 #endif
 
+#if PC_HOSTED == 1
+#include "wire_trace.h"
+#endif
+
 static bool cmd_version(target_s *t, int argc, const char **argv);
 static bool cmd_help(target_s *t, int argc, const char **argv);
 
@@ -74,6 +78,7 @@ static bool cmd_debug_bmp(target_s *t, int argc, const char **argv);
 #endif
 #if PC_HOSTED == 1
 static bool cmd_shutdown_bmda(target_s *t, int argc, const char **argv);
+static bool cmd_wire_trace(target_s *t, int argc, const char **argv);
 #endif
 
 const command_s cmd_list[] = {
@@ -101,9 +106,9 @@ const command_s cmd_list[] = {
 #endif
 #ifdef PLATFORM_HAS_TRACESWO
 #if defined TRACESWO_PROTOCOL && TRACESWO_PROTOCOL == 2
-	{"traceswo", cmd_traceswo, "Start trace capture, NRZ mode: [BAUDRATE] [decode [CHANNEL_NR ...]]"},
+	{"traceswo", cmd_traceswo, "Start trace capture, NRZ mode: [BAUDRATE] [decode|framed [CHANNEL_NR ...]] | status"},
 #else
-	{"traceswo", cmd_traceswo, "Start trace capture, Manchester mode: [decode [CHANNEL_NR ...]]"},
+	{"traceswo", cmd_traceswo, "Start trace capture, Manchester mode: [decode|framed [CHANNEL_NR ...]] | status"},
 #endif
 #endif
 	{"heapinfo", cmd_heapinfo, "Set semihosting heapinfo: HEAP_BASE HEAP_LIMIT STACK_BASE STACK_LIMIT"},
@@ -112,6 +117,7 @@ const command_s cmd_list[] = {
 #endif
 #if PC_HOSTED == 1
 	{"shutdown_bmda", cmd_shutdown_bmda, "Tell the BMDA server to shut down when the GDB connection closes"},
+	{"wire_trace", cmd_wire_trace, "Print the wire trace histogram and write out the trace recorded so far"},
 #endif
 	{NULL, NULL, NULL},
 };
@@ -143,6 +149,10 @@ int command_process(target_s *const t, char *const cmd_buffer)
 	for (const char *part = strtok_r(cmd_buffer, " \t", &token_state); part; part = strtok_r(NULL, " \t", &token_state))
 		argv[argc++] = part;
 
+	/* Monitor commands can change anything about the target, so don't let them see or leave stale reads */
+	if (t)
+		target_read_cache_flush(t);
+
 	/* Look for match and call handler */
 	for (const command_s *cmd = cmd_list; cmd->cmd; ++cmd) {
 		/* Accept a partial match as GDB does.
@@ -584,13 +594,39 @@ static bool cmd_rtt(target_s *t, int argc, const char **argv)
 #endif
 
 #ifdef PLATFORM_HAS_TRACESWO
+#if TRACESWO_PROTOCOL == 2
+static void traceswo_display_stats(void)
+{
+	traceswo_stats_s stats;
+	traceswo_get_stats(&stats);
+	gdb_outf("Buffer: %" PRIu32 " of %" PRIu32 " bytes in use, high water mark %" PRIu32 " bytes\n", stats.buffered,
+		stats.buffer_size, stats.high_water);
+	gdb_outf("Overflows: %" PRIu32 ", %" PRIu32 " bytes dropped\n", stats.overflows, stats.dropped_bytes);
+}
+#else
+static void traceswo_display_stats(void)
+{
+	const uint32_t baudrate = traceswo_get_baudrate();
+	if (baudrate)
+		gdb_outf("Detected bit rate: %" PRIu32 "\n", baudrate);
+	else
+		gdb_out("No Manchester frames seen yet\n");
+}
+#endif
+
 static bool cmd_traceswo(target_s *t, int argc, const char **argv)
 {
 	(void)t;
+	/* argument: 'status' literal to report on the capture */
+	if (argc == 2 && !strcmp(argv[1], "status")) {
+		traceswo_display_stats();
+		return true;
+	}
 #if TRACESWO_PROTOCOL == 2
 	uint32_t baudrate = SWO_DEFAULT_BAUD;
 #endif
 	uint32_t swo_channelmask = 0; /* swo decoding off */
+	bool swo_framed = false;
 	uint8_t decode_arg = 1;
 #if TRACESWO_PROTOCOL == 2
 	/* argument: optional baud rate for async mode */
@@ -601,8 +637,11 @@ static bool cmd_traceswo(target_s *t, int argc, const char **argv)
 		decode_arg = 2;
 	}
 #endif
+	/* argument: 'framed' literal, decode into per-port frames on the trace endpoint */
+	if (argc > decode_arg && !strcmp(argv[decode_arg], "framed"))
+		swo_framed = true;
 	/* argument: 'decode' literal */
-	if (argc > decode_arg && !strncmp(argv[decode_arg], "decode", strlen(argv[decode_arg]))) {
+	if (argc > decode_arg && (swo_framed || !strncmp(argv[decode_arg], "decode", strlen(argv[decode_arg])))) {
 		swo_channelmask = 0xffffffffU; /* decoding all channels */
 		/* arguments: channels to decode */
 		if (argc > decode_arg + 1) {
@@ -625,6 +664,7 @@ static bool cmd_traceswo(target_s *t, int argc, const char **argv)
 	}
 	gdb_outf("\n");
 
+	traceswo_setframing(swo_framed);
 #if TRACESWO_PROTOCOL == 2
 	traceswo_init(baudrate, swo_channelmask);
 #else
@@ -662,6 +702,18 @@ static bool cmd_shutdown_bmda(target_s *t, int argc, const char **argv)
 	shutdown_bmda = true;
 	return true;
 }
+
+static bool cmd_wire_trace(target_s *t, int argc, const char **argv)
+{
+	(void)t;
+	(void)argc;
+	(void)argv;
+	if (!wire_trace_dump()) {
+		gdb_out("Wire tracing is not active, start BMDA with --trace to enable it\n");
+		return false;
+	}
+	return true;
+}
 #endif
 
 /*
@@ -20,7 +20,9 @@
 
 #include "general.h"
 #include "target.h"
+#include "target_internal.h"
 #include "gdb_if.h"
+#include "buffer_utils.h"
 
 #if !defined(STM32F0) && !defined(STM32F1) && !defined(STM32F2) && !defined(STM32F3) && !defined(STM32F4) && \
 	!defined(STM32F7) && !defined(STM32L0) && !defined(STM32L1) && !defined(STM32G0) && !defined(STM32G4)
@@ -100,6 +102,45 @@ static uint32_t crc32_calc(const uint32_t crc, const uint8_t data)
 	return (crc << 8U) ^ crc32_table[((crc >> 24U) ^ data) & 0xffU];
 }
 
+#if PC_HOSTED == 1
+/*
+ * Slicing-by-8 tables, where crc32_slice_table[n] gives the contribution of a byte which is
+ * followed by n more bytes in the block. Built from crc32_table on first use.
+ */
+static uint32_t crc32_slice_table[8U][256U];
+static bool crc32_slice_table_valid = false;
+
+static void crc32_slice_table_init(void)
+{
+	for (size_t i = 0; i < 256U; ++i)
+		crc32_slice_table[0][i] = crc32_table[i];
+	for (size_t slice = 1; slice < 8U; ++slice) {
+		for (size_t i = 0; i < 256U; ++i) {
+			const uint32_t value = crc32_slice_table[slice - 1U][i];
+			crc32_slice_table[slice][i] = (value << 8U) ^ crc32_table[value >> 24U];
+		}
+	}
+	crc32_slice_table_valid = true;
+}
+
+static uint32_t crc32_calc_block(uint32_t crc, const uint8_t *const data, const size_t len)
+{
+	size_t offset = 0;
+	/* Consume the data 8 bytes at a time, folding the CRC into the first 4 of them */
+	for (; offset + 8U <= len; offset += 8U) {
+		crc ^= read_be4(data, offset);
+		crc = crc32_slice_table[7][crc >> 24U] ^ crc32_slice_table[6][(crc >> 16U) & 0xffU] ^
+			crc32_slice_table[5][(crc >> 8U) & 0xffU] ^ crc32_slice_table[4][crc & 0xffU] ^
+			crc32_slice_table[3][data[offset + 4U]] ^ crc32_slice_table[2][data[offset + 5U]] ^
+			crc32_slice_table[1][data[offset + 6U]] ^ crc32_slice_table[0][data[offset + 7U]];
+	}
+	/* Then mop up whatever is left a byte at a time */
+	for (; offset < len; ++offset)
+		crc = crc32_calc(crc, data[offset]);
+	return crc;
+}
+#endif
+
 static bool generic_crc32(target_s *const target, uint32_t *const result, const uint32_t base, const size_t len)
 {
 	uint32_t crc = 0xffffffffU;
@@ -108,9 +149,11 @@ static bool generic_crc32(target_s *const target, uint32_t *const result, const
 	 * Reading a 2 MByte on a H743 takes about 80 s@128, 28s @ 1k,
 	 * 22 s @ 4k and 21 s @ 64k
 	 */
-	uint8_t bytes[4096U];
+	static uint8_t bytes[65536U];
+	if (!crc32_slice_table_valid)
+		crc32_slice_table_init();
 #else
-	uint8_t bytes[128U];
+	uint8_t bytes[1024U]; /* ADIv5 MEM-AP AutoInc range */
 #endif
 
 	uint32_t last_time = platform_time_ms();
@@ -126,8 +169,12 @@ static bool generic_crc32(target_s *const target, uint32_t *const result, const
 			return false;
 		}
 
+#if PC_HOSTED == 1
+		crc = crc32_calc_block(crc, bytes, read_len);
+#else
 		for (size_t i = 0; i < read_len; i++)
 			crc = crc32_calc(crc, bytes[i]);
+#endif
 	}
 	*result = crc;
 	return true;
@@ -135,7 +182,6 @@ static bool generic_crc32(target_s *const target, uint32_t *const result, const
 
 #else
 #include <libopencm3/stm32/crc.h>
-#include "buffer_utils.h"
 
 static bool stm32_crc32(target_s *const target, uint32_t *const result, const uint32_t base, const size_t len)
 {
@@ -190,11 +236,14 @@ bool bmd_crc32(target_s *const target, uint32_t *const result, const uint32_t ba
 #ifndef DEBUG_INFO_IS_NOOP
 	const uint32_t start_time = platform_time_ms();
 #endif
+	/* If the target can compute the CRC itself, only the result has to come back over the link */
+	bool status = target->crc32 && target->crc32(target, result, base, len);
+	if (!status)
 #if !defined(STM32F0) && !defined(STM32F1) && !defined(STM32F2) && !defined(STM32F3) && !defined(STM32F4) && \
 	!defined(STM32F7) && !defined(STM32L0) && !defined(STM32L1) && !defined(STM32G0) && !defined(STM32G4)
-	const bool status = generic_crc32(target, result, base, len);
+		status = generic_crc32(target, result, base, len);
 #else
-	const bool status = stm32_crc32(target, result, base, len);
+		status = stm32_crc32(target, result, base, len);
 #endif
 #ifndef DEBUG_INFO_IS_NOOP
 	/* "generic_crc32: 08000110+75272 -> 1353ms, 54 KiB/s" */
@@ -345,6 +345,23 @@ int gdb_main_loop(target_controller_s *tc, char *pbuf, size_t pbuf_size, size_t
 		break;
 	}
 
+	case 'x': { /* 'x addr,len': Read len bytes from addr, replying in binary */
+		uint32_t addr, len;
+		ERROR_IF_NO_TARGET();
+		sscanf(pbuf, "x%" SCNx32 ",%" SCNx32, &addr, &len);
+		if (len > pbuf_size) {
+			gdb_putpacketz("E02");
+			break;
+		}
+		DEBUG_GDB("x packet: addr = %" PRIx32 ", len = %" PRIx32 "\n", addr, len);
+		/* The request has been parsed, so read straight into the packet buffer and send it back from there */
+		if (target_mem_read(cur_target, pbuf, addr, len))
+			gdb_putpacketz("E01");
+		else
+			gdb_putpacket2("b", 1U, pbuf, len);
+		break;
+	}
+
 	case 'Q': /* General set packet */
 	case 'q': /* General query packet */
 		handle_q_packet(pbuf, size);
@@ -441,7 +458,7 @@ static void exec_q_supported(const char *packet, const size_t length)
 	gdb_set_noackmode(false);
 
 	gdb_putpacket_f("PacketSize=%X;qXfer:memory-map:read+;qXfer:features:read+;"
-					"vContSupported+" GDB_QSUPPORTED_NOACKMODE,
+					"vContSupported+;binary-upload+" GDB_QSUPPORTED_NOACKMODE,
 		GDB_MAX_PACKET_SIZE);
 }
 
@@ -832,8 +849,13 @@ void gdb_poll_target(void)
 	/* poll target */
 	target_addr_t watch;
 	target_halt_reason_e reason = target_halt_poll(cur_target, &watch);
-	if (!reason)
+	if (!reason) {
+		/* Stream out any semihosting console output buffered while the target runs */
+		semihosting_stdout_flush(false);
 		return;
+	}
+	/* Send as much of that output as the host will take right now, without holding up the stop reply */
+	semihosting_stdout_flush(false);
 
 	/* switch polling off */
 	gdb_target_running = false;
@@ -109,7 +109,7 @@
 #define DEBUG_WIRE(...) PRINT_NOOP(__VA_ARGS__)
 #define DEBUG_WIRE_IS_NOOP
 
-void debug_serial_send_stdout(const uint8_t *data, size_t len);
+size_t debug_serial_send_stdout(const uint8_t *data, size_t len);
 #else
 #include "debug.h"
 
@@ -30,6 +30,12 @@
  * The idea is to use TIM3 input capture modes to capture pulse timings.
  * These can be capture directly to RAM by DMA.
  * The core can then process the buffer to extract the frame.
+ *
+ * Platforms that define TRACE_DMA_BUS have each rising edge burst CCR1 and CCR2 into a
+ * circular DMA buffer, which is then decoded in bulk from the DMA half/full transfer interrupts
+ * and from the timer update interrupt that fires once the line has gone idle at the end of a frame.
+ * Otherwise (or if TRACE_DMA_AVAILABLE() says the DMA channel is in use) every edge is decoded
+ * directly from the capture interrupt.
  */
 #include "general.h"
 #include "platform.h"
@@ -39,6 +45,14 @@
 #include <libopencm3/cm3/nvic.h>
 #include <libopencm3/stm32/timer.h>
 #include <libopencm3/stm32/rcc.h>
+#ifdef TRACE_DMA_BUS
+#include <libopencm3/stm32/dma.h>
+#endif
+
+/* Timers on a prescaled APB1 run at twice the bus clock */
+#ifndef TRACE_TIM_FREQ
+#define TRACE_TIM_FREQ (rcc_apb1_frequency * 2U)
+#endif
 
 /* SWO decoding */
 static bool decoding = false;
@@ -46,6 +60,34 @@ static bool decoding = false;
 static uint8_t trace_usb_buf[64];
 static uint8_t trace_usb_buf_size;
 
+#define ALLOWED_DUTY_ERROR 5
+
+/* Manchester decoder state */
+static uint16_t bt; /* Half-bit time of the frame being decoded, 0 if not synchronised */
+static uint8_t lastbit;
+static uint8_t decbuf[17];
+static uint8_t decbuf_pos;
+static uint8_t halfbit;
+static uint8_t notstart;
+/* Half-bit time of the most recent start bit, used to report the detected bit rate */
+static volatile uint16_t detected_half_bit;
+
+#ifdef TRACE_DMA_BUS
+/* Number of edges the capture buffer holds, each is a CCR1 (cycle) + CCR2 (high time) pair */
+#define TRACE_CAPTURE_COUNT 256U
+/* Burst CCR1 and CCR2 via TIMx_DMAR: DBA is the word offset of CCR1 (0x34), DBL is 2 transfers - 1 */
+#define TRACE_TIM_DCR_CAPTURE ((1U << 8U) | (0x34U >> 2U))
+
+static uint16_t trace_capture_buf[TRACE_CAPTURE_COUNT * 2U];
+static uint32_t trace_capture_read_index;
+static bool trace_capture_dma = false;
+
+static void trace_capture_dma_init(void);
+#endif
+
+static void trace_frame_sync(uint16_t half_bit);
+static void trace_frame_flush(void);
+
 void traceswo_init(uint32_t swo_chan_bitmask)
 {
 	TRACE_TIM_CLK_EN();
@@ -73,7 +115,13 @@ void traceswo_init(uint32_t swo_chan_bitmask)
 	/* Enable capture interrupt */
 	nvic_set_priority(TRACE_IRQ, IRQ_PRI_TRACE);
 	nvic_enable_irq(TRACE_IRQ);
-	timer_enable_irq(TRACE_TIM, TIM_DIER_CC1IE);
+#ifdef TRACE_DMA_BUS
+	trace_capture_dma = TRACE_DMA_AVAILABLE();
+	if (trace_capture_dma)
+		trace_capture_dma_init();
+	else
+#endif
+		timer_enable_irq(TRACE_TIM, TIM_DIER_CC1IE);
 
 	/* Enable the capture channels */
 	timer_ic_enable(TRACE_TIM, TIM_IC1);
@@ -85,11 +133,29 @@ void traceswo_init(uint32_t swo_chan_bitmask)
 	decoding = (swo_chan_bitmask != 0);
 }
 
+uint32_t traceswo_get_baudrate(void)
+{
+	const uint16_t half_bit = detected_half_bit;
+	if (!half_bit)
+		return 0;
+	/* A Manchester bit is two half-bit periods long */
+	return TRACE_TIM_FREQ / (2U * half_bit);
+}
+
 void trace_buf_push(uint8_t *buf, int len)
 {
-	if (decoding)
-		traceswo_decode(usbdev, CDCACM_UART_ENDPOINT, buf, len);
-	else if (usbd_ep_write_packet(usbdev, USB_REQ_TYPE_IN | TRACE_ENDPOINT, buf, len) != len) {
+	/*
+	 * Anything still waiting for the endpoint has to go out first to keep the stream in order. The decoder
+	 * can also refuse data when framed output can't get onto the endpoint, in which case it's kept for later
+	 */
+	uint16_t result = 0;
+	if (!trace_usb_buf_size) {
+		if (decoding)
+			result = traceswo_decode(usbdev, CDCACM_UART_ENDPOINT, buf, len);
+		else
+			result = usbd_ep_write_packet(usbdev, USB_REQ_TYPE_IN | TRACE_ENDPOINT, buf, len);
+	}
+	if (result != len) {
 		if (trace_usb_buf_size + len > 64) {
 			/* Stall if upstream to too slow. */
 			usbd_ep_stall_set(usbdev, USB_REQ_TYPE_IN | TRACE_ENDPOINT, 1);
@@ -103,66 +169,56 @@ void trace_buf_push(uint8_t *buf, int len)
 
 void trace_buf_drain(usbd_device *dev, uint8_t ep)
 {
+	/* Let the decoder send any framed output it could not fit in the endpoint last time */
+	if (decoding && !trace_usb_buf_size)
+		traceswo_decode(dev, CDCACM_UART_ENDPOINT, NULL, 0);
 	if (!trace_usb_buf_size)
 		return;
 
+	uint16_t result;
 	if (decoding)
-		traceswo_decode(dev, CDCACM_UART_ENDPOINT, trace_usb_buf, trace_usb_buf_size);
+		result = traceswo_decode(dev, CDCACM_UART_ENDPOINT, trace_usb_buf, trace_usb_buf_size);
 	else
-		usbd_ep_write_packet(dev, ep, trace_usb_buf, trace_usb_buf_size);
-	trace_usb_buf_size = 0;
+		result = usbd_ep_write_packet(dev, ep, trace_usb_buf, trace_usb_buf_size);
+	/* If the data was refused again, keep it for the next time the endpoint drains */
+	if (result)
+		trace_usb_buf_size = 0;
 }
 
-#define ALLOWED_DUTY_ERROR 5
-
-void TRACE_ISR(void)
+/*
+ * Feed one captured pulse into the Manchester decoder. cycle is the time between the previous
+ * and current rising edges and duty the high time within that. complete is false when only the
+ * falling edge was captured. Returns false when the frame has ended or sync was lost.
+ */
+static bool trace_decode_pulse(const uint16_t cycle, uint16_t duty, const bool complete)
 {
-	uint16_t status = TIM_SR(TRACE_TIM);
-	static uint16_t bt;
-	static uint8_t lastbit;
-	static uint8_t decbuf[17];
-	static uint8_t decbuf_pos;
-	static uint8_t halfbit;
-	static uint8_t notstart;
-
-	/* Reset decoder state if capture overflowed */
-	if (status & (TIM_SR_CC1OF | TIM_SR_UIF)) {
-		timer_clear_flag(TRACE_TIM, TIM_SR_CC1OF | TIM_SR_UIF);
-		if (!(status & (TIM_SR_CC2IF | TIM_SR_CC1IF)))
-			goto flush_and_reset;
-	}
-
-	const uint16_t cycle = TIM_CCR1(TRACE_TIM);
-	uint16_t duty = TIM_CCR2(TRACE_TIM);
-
 	/* Reset decoder state if crazy things happened */
 	if ((bt && (duty / bt > 2U || duty / bt == 0)) || duty == 0)
-		goto flush_and_reset;
+		return false;
 
-	if (!(status & TIM_SR_CC1IF))
+	if (!complete)
 		notstart = 1;
 
 	if (!bt) {
 		if (notstart) {
 			notstart = 0;
-			return;
+			return true;
 		}
 		/* First bit, sync decoder */
+		const uint16_t half_bit = duty;
 		duty -= ALLOWED_DUTY_ERROR;
 		const uint16_t duty_cycle = cycle / duty;
 		if (duty_cycle != 2U && duty_cycle != 3U)
-			return;
+			return true;
 		bt = duty;
 		lastbit = 1;
 		halfbit = 0;
-		timer_set_period(TRACE_TIM, duty * 6U);
-		timer_clear_flag(TRACE_TIM, TIM_SR_UIF);
-		timer_enable_irq(TRACE_TIM, TIM_DIER_UIE);
+		trace_frame_sync(half_bit);
 	} else {
 		/* If high time is extended we need to flip the bit */
 		if (duty / bt > 1U) {
 			if (!halfbit) /* lost sync somehow */
-				goto flush_and_reset;
+				return false;
 			halfbit = 0;
 			lastbit ^= 1U;
 		}
@@ -170,27 +226,157 @@ void TRACE_ISR(void)
 		++decbuf_pos;
 	}
 
-	if (!(status & TIM_SR_CC1IF) || (cycle - duty) / bt > 2)
-		goto flush_and_reset;
+	if (!complete || (cycle - duty) / bt > 2)
+		return false;
 
 	if ((cycle - duty) / bt > 1) {
 		/* If low time extended we need to pack another bit. */
 		if (halfbit) /* this is a valid stop-bit or we lost sync */
-			goto flush_and_reset;
+			return false;
 		halfbit = 1;
 		lastbit ^= 1U;
 		decbuf[decbuf_pos >> 3U] |= lastbit << (decbuf_pos & 7U);
 		++decbuf_pos;
 	}
 
-	if (decbuf_pos < 128U)
+	return decbuf_pos < 128U;
+}
+
+/* Called when the decoder locks onto a start bit, half_bit being its high time in timer ticks */
+static void trace_frame_sync(const uint16_t half_bit)
+{
+	detected_half_bit = half_bit;
+	/* The line being idle for 6 half-bit times marks the end of the frame */
+	timer_set_period(TRACE_TIM, bt < UINT16_MAX / 6U ? bt * 6U : UINT16_MAX);
+#ifdef TRACE_DMA_BUS
+	/* In DMA mode the timeout is armed by the first edge of each frame instead */
+	if (trace_capture_dma)
 		return;
+#endif
+	timer_clear_flag(TRACE_TIM, TIM_SR_UIF);
+	timer_enable_irq(TRACE_TIM, TIM_DIER_UIE);
+}
 
-flush_and_reset:
-	timer_set_period(TRACE_TIM, -1);
-	timer_disable_irq(TRACE_TIM, TIM_DIER_UIE);
-	trace_buf_push(decbuf, decbuf_pos >> 3U);
+static void trace_frame_flush(void)
+{
+	if (decbuf_pos >= 8U)
+		trace_buf_push(decbuf, decbuf_pos >> 3U);
 	bt = 0;
 	decbuf_pos = 0;
 	memset(decbuf, 0, sizeof(decbuf));
 }
+
+#ifdef TRACE_DMA_BUS
+static void trace_capture_dma_init(void)
+{
+	rcc_periph_clock_enable(TRACE_DMA_CLK);
+
+	dma_channel_reset(TRACE_DMA_BUS, TRACE_DMA_CHAN);
+	dma_set_peripheral_address(TRACE_DMA_BUS, TRACE_DMA_CHAN, (uint32_t)&TIM_DMAR(TRACE_TIM));
+	dma_set_memory_address(TRACE_DMA_BUS, TRACE_DMA_CHAN, (uint32_t)trace_capture_buf);
+	dma_set_number_of_data(TRACE_DMA_BUS, TRACE_DMA_CHAN, TRACE_CAPTURE_COUNT * 2U);
+	dma_set_read_from_peripheral(TRACE_DMA_BUS, TRACE_DMA_CHAN);
+	dma_enable_memory_increment_mode(TRACE_DMA_BUS, TRACE_DMA_CHAN);
+	dma_set_peripheral_size(TRACE_DMA_BUS, TRACE_DMA_CHAN, DMA_CCR_PSIZE_16BIT);
+	dma_set_memory_size(TRACE_DMA_BUS, TRACE_DMA_CHAN, DMA_CCR_MSIZE_16BIT);
+	dma_set_priority(TRACE_DMA_BUS, TRACE_DMA_CHAN, DMA_CCR_PL_VERY_HIGH);
+	dma_enable_circular_mode(TRACE_DMA_BUS, TRACE_DMA_CHAN);
+	dma_enable_half_transfer_interrupt(TRACE_DMA_BUS, TRACE_DMA_CHAN);
+	dma_enable_transfer_complete_interrupt(TRACE_DMA_BUS, TRACE_DMA_CHAN);
+	trace_capture_read_index = 0;
+
+	nvic_set_priority(TRACE_DMA_IRQ, IRQ_PRI_TRACE);
+	nvic_enable_irq(TRACE_DMA_IRQ);
+	dma_enable_channel(TRACE_DMA_BUS, TRACE_DMA_CHAN);
+
+	/* Each rising edge (CC1) bursts CCR1 and CCR2 into the capture buffer */
+	TIM_DCR(TRACE_TIM) = TRACE_TIM_DCR_CAPTURE;
+	timer_enable_irq(TRACE_TIM, TIM_DIER_CC1DE);
+	/* Only the counter overflowing (the line going idle) should flag an update, not slave mode resets */
+	timer_update_on_overflow(TRACE_TIM);
+	timer_set_period(TRACE_TIM, UINT16_MAX);
+	/* The CC1 interrupt is only used to spot the first edge of a frame */
+	timer_enable_irq(TRACE_TIM, TIM_DIER_CC1IE);
+}
+
+/* Index of the next capture the DMA will complete */
+static uint32_t trace_capture_write_index(void)
+{
+	return ((TRACE_CAPTURE_COUNT * 2U) - dma_get_number_of_data(TRACE_DMA_BUS, TRACE_DMA_CHAN)) / 2U;
+}
+
+/* Decode every capture up to (but not including) end_index */
+static void trace_capture_process(const uint32_t end_index)
+{
+	while (trace_capture_read_index != end_index) {
+		const uint16_t *const capture = &trace_capture_buf[trace_capture_read_index * 2U];
+		if (!trace_decode_pulse(capture[0], capture[1], true))
+			trace_frame_flush();
+		trace_capture_read_index = (trace_capture_read_index + 1U) % TRACE_CAPTURE_COUNT;
+	}
+}
+
+void TRACE_DMA_ISR(void)
+{
+	dma_clear_interrupt_flags(TRACE_DMA_BUS, TRACE_DMA_CHAN, DMA_IFCR_CGIF_BIT);
+	trace_capture_process(trace_capture_write_index());
+}
+
+static void trace_capture_timer_isr(void)
+{
+	/* First edge of a new frame: stop listening for edges and wait for the line to go idle again */
+	if (TIM_DIER(TRACE_TIM) & TIM_DIER_CC1IE) {
+		timer_disable_irq(TRACE_TIM, TIM_DIER_CC1IE);
+		timer_clear_flag(TRACE_TIM, TIM_SR_UIF);
+		timer_enable_irq(TRACE_TIM, TIM_DIER_UIE);
+		return;
+	}
+
+	const uint16_t status = TIM_SR(TRACE_TIM);
+	if (!(status & TIM_SR_UIF))
+		return;
+	timer_clear_flag(TRACE_TIM, TIM_SR_UIF | TIM_SR_CC1OF);
+
+	/* The line went idle, decode the rest of the frame in one go */
+	const uint32_t frame_end = trace_capture_write_index();
+	trace_capture_process(frame_end);
+	/* The last pulse of the frame has no rising edge after it, so only its falling edge was captured */
+	if (status & TIM_SR_CC2IF)
+		trace_decode_pulse(0, TIM_CCR2(TRACE_TIM), false);
+	trace_frame_flush();
+
+	/* If the next frame already started while we were busy, keep waiting for its end instead */
+	if (trace_capture_write_index() == frame_end) {
+		timer_disable_irq(TRACE_TIM, TIM_DIER_UIE);
+		timer_enable_irq(TRACE_TIM, TIM_DIER_CC1IE);
+	}
+}
+#endif
+
+void TRACE_ISR(void)
+{
+#ifdef TRACE_DMA_BUS
+	if (trace_capture_dma) {
+		trace_capture_timer_isr();
+		return;
+	}
+#endif
+	const uint16_t status = TIM_SR(TRACE_TIM);
+
+	/* Reset decoder state if capture overflowed */
+	if (status & (TIM_SR_CC1OF | TIM_SR_UIF)) {
+		timer_clear_flag(TRACE_TIM, TIM_SR_CC1OF | TIM_SR_UIF);
+		if (!(status & (TIM_SR_CC2IF | TIM_SR_CC1IF)))
+			goto flush_and_reset;
+	}
+
+	const uint16_t cycle = TIM_CCR1(TRACE_TIM);
+	const uint16_t duty = TIM_CCR2(TRACE_TIM);
+	if (trace_decode_pulse(cycle, duty, status & TIM_SR_CC1IF))
+		return;
+
+flush_and_reset:
+	timer_set_period(TRACE_TIM, -1);
+	timer_disable_irq(TRACE_TIM, TIM_DIER_UIE);
+	trace_frame_flush();
+}
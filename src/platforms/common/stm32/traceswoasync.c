@@ -28,11 +28,11 @@
 
 /* TDO/TRACESWO signal comes into the SWOUSART RX pin. */
 
-#include <stdatomic.h>
 #include "general.h"
 #include "platform.h"
 #include "usb.h"
 #include "traceswo.h"
+#include "traceswoasync_buffer.h"
 
 #include <libopencmsis/core_cm3.h>
 #include <libopencm3/cm3/nvic.h>
@@ -41,38 +41,8 @@
 #include <libopencm3/stm32/usart.h>
 #include <libopencm3/stm32/dma.h>
 
-static volatile uint32_t write_index; /* Packet currently received via UART */
-static volatile uint32_t read_index;  /* Packet currently waiting to transmit to USB */
-/* Packets arrived from the SWO interface */
-static uint8_t trace_rx_buf[NUM_TRACE_PACKETS * TRACE_ENDPOINT_SIZE];
 /* Packet pingpong buffer used for receiving packets */
 static uint8_t pingpong_buf[2 * TRACE_ENDPOINT_SIZE];
-/* SWO decoding */
-static bool decoding = false;
-
-void trace_buf_drain(usbd_device *dev, uint8_t ep)
-{
-	static atomic_flag reentry_flag = ATOMIC_FLAG_INIT;
-
-	/* If we are already in this routine then we don't need to come in again */
-	if (atomic_flag_test_and_set_explicit(&reentry_flag, memory_order_relaxed))
-		return;
-	/* Attempt to write everything we buffered */
-	if (write_index != read_index) {
-		uint16_t result;
-		if (decoding)
-			/* write decoded swo packets to the uart port */
-			result = traceswo_decode(
-				dev, CDCACM_UART_ENDPOINT, &trace_rx_buf[read_index * TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE);
-		else
-			/* write raw swo packets to the trace port */
-			result =
-				usbd_ep_write_packet(dev, ep, &trace_rx_buf[read_index * TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE);
-		if (result)
-			read_index = (read_index + 1U) % NUM_TRACE_PACKETS;
-	}
-	atomic_flag_clear_explicit(&reentry_flag, memory_order_relaxed);
-}
 
 void traceswo_setspeed(uint32_t baudrate)
 {
@@ -99,7 +69,7 @@ void traceswo_setspeed(uint32_t baudrate)
 
 	usart_enable(SWO_UART);
 	nvic_enable_irq(SWO_DMA_IRQ);
-	write_index = read_index = 0;
+	trace_rx_reset();
 	dma_set_memory_address(SWO_DMA_BUS, SWO_DMA_CHAN, (uint32_t)pingpong_buf);
 	dma_set_number_of_data(SWO_DMA_BUS, SWO_DMA_CHAN, 2 * TRACE_ENDPOINT_SIZE);
 	dma_enable_channel(SWO_DMA_BUS, SWO_DMA_CHAN);
@@ -110,14 +80,12 @@ void SWO_DMA_ISR(void)
 {
 	if (DMA_ISR(SWO_DMA_BUS) & DMA_ISR_HTIF(SWO_DMA_CHAN)) {
 		DMA_IFCR(SWO_DMA_BUS) |= DMA_ISR_HTIF(SWO_DMA_CHAN);
-		memcpy(&trace_rx_buf[write_index * TRACE_ENDPOINT_SIZE], pingpong_buf, TRACE_ENDPOINT_SIZE);
+		trace_rx_push(pingpong_buf);
 	}
 	if (DMA_ISR(SWO_DMA_BUS) & DMA_ISR_TCIF(SWO_DMA_CHAN)) {
 		DMA_IFCR(SWO_DMA_BUS) |= DMA_ISR_TCIF(SWO_DMA_CHAN);
-		memcpy(
-			&trace_rx_buf[write_index * TRACE_ENDPOINT_SIZE], &pingpong_buf[TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE);
+		trace_rx_push(&pingpong_buf[TRACE_ENDPOINT_SIZE]);
 	}
-	write_index = (write_index + 1U) % NUM_TRACE_PACKETS;
 	trace_buf_drain(usbdev, TRACE_ENDPOINT | USB_REQ_TYPE_IN);
 }
 
@@ -136,5 +104,5 @@ void traceswo_init(uint32_t baudrate, uint32_t swo_chan_bitmask)
 	nvic_enable_irq(SWO_DMA_IRQ);
 	traceswo_setspeed(baudrate);
 	traceswo_setmask(swo_chan_bitmask);
-	decoding = (swo_chan_bitmask != 0);
+	trace_rx_set_decoding(swo_chan_bitmask != 0);
 }
@@ -0,0 +1,144 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Based on work that is Copyright (C) 2017 Black Sphere Technologies Ltd.
+ * Copyright (C) 2017 Dave Marples <dave@marples.net>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This file implements the capture ring shared by the async Trace/SWO drivers,
+ * moving packets from the UART DMA interrupt to USB and accounting for overflows.
+ *
+ * ARM DDI 0403D - ARMv7M Architecture Reference Manual
+ */
+
+#include <stdatomic.h>
+#include "general.h"
+#include "platform.h"
+#include "usb.h"
+#include "traceswo.h"
+#include "traceswoasync_buffer.h"
+
+/* ITM overflow packet, inserted in-band after data had to be dropped (ARM DDI 0403D D4.2.3) */
+#define ITM_OVERFLOW_PACKET 0x70U
+
+#define OVERFLOW_SLOT_WORDS ((NUM_TRACE_PACKETS + 31U) / 32U)
+
+static volatile uint32_t write_index; /* Packet currently received via UART */
+static volatile uint32_t read_index;  /* Packet currently waiting to transmit to USB */
+/* Packets arrived from the SWO interface */
+static uint8_t trace_rx_buf[NUM_TRACE_PACKETS * TRACE_ENDPOINT_SIZE];
+/* SWO decoding */
+static bool decoding = false;
+/* Overflow accounting, written by the DMA ISR only */
+static volatile uint32_t dropped_bytes;
+static volatile uint32_t overflow_count;
+static volatile uint32_t high_water_packets;
+/*
+ * One bit per ring slot, set when data was dropped just before the packet that lands in that slot.
+ * The overflow marker must go out when the drain reaches the slot, so it sits at the gap in the stream.
+ * This is set by the DMA ISR and cleared by the USB ISR, which can preempt each other, so it's only
+ * ever modified atomically.
+ */
+static volatile uint32_t overflow_slots[OVERFLOW_SLOT_WORDS];
+
+static inline bool trace_rx_gap_at(const uint32_t slot)
+{
+	return overflow_slots[slot / 32U] & (1U << (slot % 32U));
+}
+
+void trace_buf_drain(usbd_device *dev, uint8_t ep)
+{
+	static atomic_flag reentry_flag = ATOMIC_FLAG_INIT;
+
+	/* If we are already in this routine then we don't need to come in again */
+	if (atomic_flag_test_and_set_explicit(&reentry_flag, memory_order_relaxed))
+		return;
+	const uint32_t slot = read_index;
+	/*
+	 * If data was dropped just before this slot, tell the host in-band by emitting
+	 * an ITM overflow packet on the raw trace endpoint ahead of the packet in it
+	 */
+	if (trace_rx_gap_at(slot)) {
+		static const uint8_t overflow_marker = ITM_OVERFLOW_PACKET;
+		if (decoding || usbd_ep_write_packet(dev, ep, &overflow_marker, 1U))
+			__atomic_fetch_and(&overflow_slots[slot / 32U], ~(1U << (slot % 32U)), __ATOMIC_RELAXED);
+	} else if (write_index != slot) {
+		/* Attempt to write everything we buffered */
+		uint16_t result;
+		if (decoding)
+			/* write decoded swo packets to the uart port */
+			result = traceswo_decode(
+				dev, CDCACM_UART_ENDPOINT, &trace_rx_buf[slot * TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE);
+		else
+			/* write raw swo packets to the trace port */
+			result = usbd_ep_write_packet(dev, ep, &trace_rx_buf[slot * TRACE_ENDPOINT_SIZE], TRACE_ENDPOINT_SIZE);
+		if (result)
+			read_index = (slot + 1U) % NUM_TRACE_PACKETS;
+	} else if (decoding)
+		/* Let the decoder send any framed output it could not fit in the endpoint last time */
+		traceswo_decode(dev, CDCACM_UART_ENDPOINT, NULL, 0);
+	atomic_flag_clear_explicit(&reentry_flag, memory_order_relaxed);
+}
+
+void trace_rx_push(const uint8_t *const data)
+{
+	const uint32_t slot = write_index;
+	const uint32_t next_index = (slot + 1U) % NUM_TRACE_PACKETS;
+	/*
+	 * If USB has not drained the ring fast enough, drop the new data rather than overwriting queued packets,
+	 * and mark the slot the next packet will land in as following a gap
+	 */
+	if (next_index == read_index) {
+		dropped_bytes += TRACE_ENDPOINT_SIZE;
+		if (!trace_rx_gap_at(slot)) {
+			++overflow_count;
+			__atomic_fetch_or(&overflow_slots[slot / 32U], 1U << (slot % 32U), __ATOMIC_RELAXED);
+		}
+		return;
+	}
+	memcpy(&trace_rx_buf[slot * TRACE_ENDPOINT_SIZE], data, TRACE_ENDPOINT_SIZE);
+	write_index = next_index;
+
+	const uint32_t used_packets = (next_index + NUM_TRACE_PACKETS - read_index) % NUM_TRACE_PACKETS;
+	if (used_packets > high_water_packets)
+		high_water_packets = used_packets;
+}
+
+void trace_rx_reset(void)
+{
+	write_index = read_index = 0;
+	dropped_bytes = 0;
+	overflow_count = 0;
+	high_water_packets = 0;
+	for (size_t i = 0; i < OVERFLOW_SLOT_WORDS; ++i)
+		overflow_slots[i] = 0U;
+}
+
+void trace_rx_set_decoding(const bool enable)
+{
+	decoding = enable;
+}
+
+void traceswo_get_stats(traceswo_stats_s *const stats)
+{
+	/* The ring always keeps one slot free to tell full from empty */
+	stats->buffer_size = (NUM_TRACE_PACKETS - 1U) * TRACE_ENDPOINT_SIZE;
+	stats->buffered = ((write_index + NUM_TRACE_PACKETS - read_index) % NUM_TRACE_PACKETS) * TRACE_ENDPOINT_SIZE;
+	stats->high_water = high_water_packets * TRACE_ENDPOINT_SIZE;
+	stats->overflows = overflow_count;
+	stats->dropped_bytes = dropped_bytes;
+}
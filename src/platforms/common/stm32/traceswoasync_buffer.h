@@ -0,0 +1,33 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2017 Black Sphere Technologies Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLATFORMS_COMMON_STM32_TRACESWOASYNC_BUFFER_H
+#define PLATFORMS_COMMON_STM32_TRACESWOASYNC_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Queue one TRACE_ENDPOINT_SIZE packet of captured trace data, dropping it if the ring is full */
+void trace_rx_push(const uint8_t *data);
+/* Empty the capture ring and reset the overflow accounting */
+void trace_rx_reset(void);
+/* Select whether queued data is decoded to USB serial or sent raw on the trace endpoint */
+void trace_rx_set_decoding(bool decoding);
+
+#endif /* PLATFORMS_COMMON_STM32_TRACESWOASYNC_BUFFER_H */
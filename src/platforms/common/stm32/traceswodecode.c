@@ -16,7 +16,11 @@
  * along with this program.	 If not, see <http://www.gnu.org/licenses/>.
  */
 
-/* Print decoded swo stream on the usb serial */
+/*
+ * Print decoded swo stream on the usb serial, or when framing is enabled, send it on the trace
+ * endpoint as a sequence of frames, each being the stimulus port number, a payload length byte
+ * and then that many bytes of payload. Consecutive data for the same port is merged into one frame.
+ */
 
 #include "general.h"
 #include "usb_serial.h"
@@ -29,12 +33,65 @@ static int swo_buf_len = 0;
 static uint32_t swo_decode = 0; /* bitmask of channels to print */
 static int swo_pkt_len = 0;     /* decoder state */
 static bool swo_print = false;
+static uint8_t swo_channel = 0; /* channel of the packet being decoded */
+
+/*
+ * Framed output is worst case 3 bytes for every 2 bytes of ITM input (a fresh frame around a
+ * 1 byte packet), so this always has room to decode a full trace packet with one still pending.
+ */
+#define SWO_FRAME_BUF_SIZE (3U * TRACE_ENDPOINT_SIZE)
+#define SWO_FRAME_NONE     UINT16_MAX
+
+static bool swo_framed = false;
+static uint8_t swo_frame_buf[SWO_FRAME_BUF_SIZE];
+static uint16_t swo_frame_len = 0;                /* bytes waiting to go out on the trace endpoint */
+static uint16_t swo_frame_start = SWO_FRAME_NONE; /* offset of the frame currently being filled */
+
+/* Send as much pending framed output as the endpoint will take, returns true once it is all gone */
+static bool swo_frame_flush(usbd_device *const usbd_dev)
+{
+	if (!swo_frame_len)
+		return true;
+	/* silently drop if usb not ready */
+	if (!usb_get_config()) {
+		swo_frame_len = 0;
+		return true;
+	}
+	const uint16_t len = MIN(swo_frame_len, TRACE_ENDPOINT_SIZE);
+	if (!usbd_ep_write_packet(usbd_dev, TRACE_ENDPOINT | USB_REQ_TYPE_IN, swo_frame_buf, len))
+		return false;
+	swo_frame_len -= len;
+	memmove(swo_frame_buf, swo_frame_buf + len, swo_frame_len);
+	return !swo_frame_len;
+}
+
+static void swo_frame_append(const uint8_t channel, const uint8_t data)
+{
+	/* Start a new frame if the port changed or the current one is full */
+	if (swo_frame_start == SWO_FRAME_NONE || swo_frame_buf[swo_frame_start] != channel ||
+		swo_frame_buf[swo_frame_start + 1U] == UINT8_MAX) {
+		swo_frame_start = swo_frame_len;
+		swo_frame_buf[swo_frame_len++] = channel;
+		swo_frame_buf[swo_frame_len++] = 0U;
+	}
+	swo_frame_buf[swo_frame_len++] = data;
+	++swo_frame_buf[swo_frame_start + 1U];
+}
 
 /* print decoded swo packet on usb serial */
 uint16_t traceswo_decode(usbd_device *usbd_dev, uint8_t addr, const void *buf, uint16_t len)
 {
 	if (usbd_dev == NULL)
 		return 0;
+	if (swo_framed) {
+		/*
+		 * Make sure there is room for everything this call could produce, otherwise
+		 * refuse the data so the caller keeps it and tries again when the endpoint drains
+		 */
+		if (SWO_FRAME_BUF_SIZE - swo_frame_len < 2U * len + 2U && !swo_frame_flush(usbd_dev) &&
+			SWO_FRAME_BUF_SIZE - swo_frame_len < 2U * len + 2U)
+			return 0;
+	}
 	const uint8_t *const data = (const uint8_t *)buf;
 	for (uint16_t i = 0; i < len; i++) {
 		const uint8_t ch = data[i];
@@ -48,8 +105,11 @@ uint16_t traceswo_decode(usbd_device *usbd_dev, uint8_t addr, const void *buf, u
 			else if (size == 0x03U)
 				swo_pkt_len = 4; /* SWO packet 0x03XXXXXXXX */
 			swo_print = (swo_pkt_len != 0) && ((swo_decode & (1UL << channel)) != 0UL);
+			swo_channel = channel;
 		} else if (swo_pkt_len <= 4) { /* data */
-			if (swo_print) {
+			if (swo_print && swo_framed)
+				swo_frame_append(swo_channel, ch);
+			else if (swo_print) {
 				swo_buf[swo_buf_len++] = ch;
 				if (swo_buf_len == sizeof(swo_buf)) {
 					if (usb_get_config() && gdb_serial_get_dtr()) /* silently drop if usb not ready */
@@ -63,6 +123,11 @@ uint16_t traceswo_decode(usbd_device *usbd_dev, uint8_t addr, const void *buf, u
 			swo_pkt_len = 0;
 		}
 	}
+	if (swo_framed) {
+		/* Don't hold framed data back waiting for more, send it now if the endpoint is free */
+		swo_frame_start = SWO_FRAME_NONE;
+		swo_frame_flush(usbd_dev);
+	}
 	return len;
 }
 
@@ -72,4 +137,11 @@ void traceswo_setmask(uint32_t mask)
 	swo_decode = mask;
 }
 
-/* not truncated */
+/* select framed output on the trace endpoint rather than raw payload on the usb serial */
+void traceswo_setframing(const bool framed)
+{
+	swo_framed = framed;
+	swo_frame_len = 0;
+	swo_frame_start = SWO_FRAME_NONE;
+	swo_pkt_len = 0;
+}
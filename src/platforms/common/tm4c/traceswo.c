@@ -37,6 +37,10 @@
 #include <libopencm3/lm4f/uart.h>
 #include <libopencm3/usb/usbd.h>
 
+#define TRACE_DEFAULT_BAUD 800000U
+
+static uint32_t trace_baudrate = TRACE_DEFAULT_BAUD;
+
 void traceswo_init(void)
 {
 	periph_clock_enable(RCC_GPIOD);
@@ -52,7 +56,8 @@ void traceswo_init(void)
 
 	/* Setup UART parameters. */
 	uart_clock_from_sysclk(TRACEUART);
-	uart_set_baudrate(TRACEUART, 800000);
+	trace_baudrate = TRACE_DEFAULT_BAUD;
+	uart_set_baudrate(TRACEUART, trace_baudrate);
 	uart_set_databits(TRACEUART, 8);
 	uart_set_stopbits(TRACEUART, 1);
 	uart_set_parity(TRACEUART, UART_PARITY_NONE);
@@ -83,10 +88,23 @@ void traceswo_init(void)
 
 void traceswo_baud(unsigned int baud)
 {
+	trace_baudrate = baud;
 	uart_set_baudrate(TRACEUART, baud);
 	uart_set_databits(TRACEUART, 8);
 }
 
+/* The UART runs at a fixed rate rather than detecting it, so report what it is set to */
+uint32_t traceswo_get_baudrate(void)
+{
+	return trace_baudrate;
+}
+
+/* SWO is not decoded on this platform, so there is nothing to frame */
+void traceswo_setframing(const bool framed)
+{
+	(void)framed;
+}
+
 #define FIFO_SIZE 256U
 
 /* RX Fifo buffer */
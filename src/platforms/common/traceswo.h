@@ -27,8 +27,21 @@
 /* Default line rate, used as default for a request without baudrate */
 #define SWO_DEFAULT_BAUD 2250000U
 void traceswo_init(uint32_t baudrate, uint32_t swo_chan_bitmask);
+
+/* Capture buffer accounting, all sizes in bytes */
+typedef struct traceswo_stats {
+	uint32_t buffer_size;   /* Usable size of the capture ring buffer */
+	uint32_t buffered;      /* Bytes currently waiting to be sent to the host */
+	uint32_t high_water;    /* Largest amount ever waiting since capture was (re)started */
+	uint32_t overflows;     /* Number of separate overflow events */
+	uint32_t dropped_bytes; /* Total trace data discarded because the buffer was full */
+} traceswo_stats_s;
+
+void traceswo_get_stats(traceswo_stats_s *stats);
 #else
 void traceswo_init(uint32_t swo_chan_bitmask);
+/* Bit rate detected from the most recent Manchester start bit, 0 if none seen yet */
+uint32_t traceswo_get_baudrate(void);
 #endif
 
 void trace_buf_drain(usbd_device *dev, uint8_t ep);
@@ -36,7 +49,10 @@ void trace_buf_drain(usbd_device *dev, uint8_t ep);
 /* Set bitmask of SWO channels to be decoded */
 void traceswo_setmask(uint32_t mask);
 
-/* Print decoded SWO packet on USB serial */
+/* Select between framed output on the trace endpoint and raw payload on USB serial for decoded SWO */
+void traceswo_setframing(bool framed);
+
+/* Print decoded SWO packet on USB serial, or send it framed on the trace endpoint */
 uint16_t traceswo_decode(usbd_device *usbd_dev, uint8_t addr, const void *buf, uint16_t len);
 
 #endif /* PLATFORMS_COMMON_TRACESWO_H */
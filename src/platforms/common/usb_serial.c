@@ -219,15 +219,20 @@ void usb_serial_set_config(usbd_device *dev, uint16_t value)
 #endif
 }
 
-void debug_serial_send_stdout(const uint8_t *const data, const size_t len)
+size_t debug_serial_send_stdout(const uint8_t *const data, const size_t len)
 {
-	for (size_t offset = 0; offset < len; offset += CDCACM_PACKET_SIZE) {
+	size_t offset = 0;
+	while (offset < len) {
 		const size_t count = MIN(len - offset, CDCACM_PACKET_SIZE);
 		nvic_disable_irq(USB_IRQ);
-		/* XXX: Do we actually care if this fails? Possibly not.. */
-		usbd_ep_write_packet(usbdev, CDCACM_UART_ENDPOINT, data + offset, count);
+		const uint16_t written = usbd_ep_write_packet(usbdev, CDCACM_UART_ENDPOINT, data + offset, count);
 		nvic_enable_irq(USB_IRQ);
+		/* Stop if the endpoint is still busy with the last packet, the caller can retry the rest later */
+		if (!written)
+			break;
+		offset += written;
 	}
+	return offset;
 }
 
 uint32_t debug_serial_fifo_send(const char *const fifo, const uint32_t fifo_begin, const uint32_t fifo_end)
@@ -132,6 +132,7 @@
 #define TRACE_TIM_CLK_EN() rcc_periph_clock_enable(RCC_TIM3)
 #define TRACE_IRQ          NVIC_TIM3_IRQ
 #define TRACE_ISR          tim3_isr
+#define TRACE_TIM_FREQ     rcc_apb1_frequency
 
 #if ENABLE_DEBUG == 1
 extern bool debug_bmp;
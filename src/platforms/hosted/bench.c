@@ -0,0 +1,263 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2026 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements the BMDA throughput benchmarks. Each one times a fixed workload shaped like a
+ * common debugger operation against the attached target - Flash write and verify, GDB `m` packet sized
+ * memory reads both running and stopped, full register file reads on each stop and RTT style polling -
+ * and reports the operation rate and throughput achieved. Run against the simulated target (--sim) these
+ * give hermetic numbers that can be compared before and after changes to the ADIv5, Flash or probe layers.
+ */
+
+#include "general.h"
+#include "target.h"
+#include "target_internal.h"
+#include "gdb_main.h"
+#include "bench.h"
+#include "utils.h"
+
+/* Upper limit on how much Flash the write and verify benchmarks cover */
+#define BENCH_FLASH_MAX 0x20000U
+/* Verify reads back in the same size chunks as the CLI does */
+#define BENCH_VERIFY_CHUNK 0x1000U
+/* The largest `m` request whose hex encoded reply fits in a GDB packet */
+#define BENCH_MEM_READ_CHUNK (GDB_PACKET_BUFFER_SIZE / 2U)
+#define BENCH_MEM_READ_TOTAL 0x40000U
+/* GDB's own `m` requests while stopped, small enough to go through the target read cache */
+#define BENCH_HALTED_READ_CHUNK 0x200U
+#define BENCH_REGS_READS     1000U
+#define BENCH_RTT_POLLS      1000U
+/* A SEGGER RTT control block header and the descriptors for one up and one down channel */
+#define BENCH_RTT_HEADER      24U
+#define BENCH_RTT_DESCRIPTORS 48U
+#define BENCH_RTT_DATA        64U
+
+static void bench_report(const char *const name, const size_t ops, const size_t bytes, uint64_t elapsed)
+{
+	if (!elapsed)
+		elapsed = 1U;
+	DEBUG_WARN("%-14s %6zu ops %10.3fms %10.3fus/op", name, ops, (double)elapsed / 1000.0, (double)elapsed / ops);
+	if (bytes)
+		DEBUG_WARN(" %10.3fkiB/s", ((double)bytes * 1000000.0) / (1024.0 * (double)elapsed));
+	DEBUG_WARN("\n");
+}
+
+static target_flash_s *bench_lowest_flash(target_s *const target)
+{
+	target_flash_s *lowest = NULL;
+	for (target_flash_s *flash = target->flash; flash; flash = flash->next) {
+		if (!lowest || flash->start < lowest->start)
+			lowest = flash;
+	}
+	return lowest;
+}
+
+static bool bench_flash(target_s *const target)
+{
+	const target_flash_s *const flash = bench_lowest_flash(target);
+	if (!flash) {
+		DEBUG_WARN("No Flash on target, skipping Flash benchmarks\n");
+		return true;
+	}
+
+	const size_t length = MIN(flash->length, BENCH_FLASH_MAX);
+	uint8_t *const image = malloc(length + BENCH_VERIFY_CHUNK);
+	if (!image) { /* malloc failed: heap exhaustion */
+		DEBUG_ERROR("malloc: failed in %s\n", __func__);
+		return false;
+	}
+	uint8_t *const readback = image + length;
+
+	/* Fill the image with a pseudo-random pattern so nothing can be skipped as already erased */
+	uint32_t seed = 0x2545f491U;
+	for (size_t offset = 0; offset < length; ++offset) {
+		seed = (seed * 1103515245U) + 12345U;
+		image[offset] = seed >> 24U;
+	}
+
+	bool result = true;
+	uint64_t start = bmda_time_us();
+	if (!target_flash_erase(target, flash->start, length) || !target_flash_write(target, flash->start, image, length) ||
+		!target_flash_complete(target)) {
+		DEBUG_ERROR("Flash write benchmark failed\n");
+		result = false;
+	} else
+		bench_report("flash write", 1U, length, bmda_time_us() - start);
+
+	start = bmda_time_us();
+	for (size_t offset = 0; result && offset < length; offset += BENCH_VERIFY_CHUNK) {
+		const size_t amount = MIN(length - offset, BENCH_VERIFY_CHUNK);
+		if (target_mem_read(target, readback, flash->start + offset, amount) ||
+			memcmp(readback, image + offset, amount) != 0) {
+			DEBUG_ERROR("Flash verify benchmark failed at 0x%08" PRIx32 "\n", (uint32_t)(flash->start + offset));
+			result = false;
+		}
+	}
+	if (result)
+		bench_report("flash verify", (length + BENCH_VERIFY_CHUNK - 1U) / BENCH_VERIFY_CHUNK, length,
+			bmda_time_us() - start);
+
+	free(image);
+	return result;
+}
+
+static bool bench_mem_read(target_s *const target, const target_ram_s *const ram)
+{
+	uint8_t data[BENCH_MEM_READ_CHUNK];
+	const size_t window = ram->length - (ram->length % BENCH_MEM_READ_CHUNK);
+	if (!window)
+		return true;
+
+	const uint64_t start = bmda_time_us();
+	size_t ops = 0;
+	for (size_t total = 0; total < BENCH_MEM_READ_TOTAL; total += BENCH_MEM_READ_CHUNK, ++ops) {
+		if (target_mem_read(target, data, ram->start + (total % window), BENCH_MEM_READ_CHUNK)) {
+			DEBUG_ERROR("Memory read benchmark failed\n");
+			return false;
+		}
+	}
+	bench_report("m read", ops, BENCH_MEM_READ_TOTAL, bmda_time_us() - start);
+	return true;
+}
+
+static bool bench_halt(target_s *const target)
+{
+	target_halt_request(target);
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, 1000);
+	target_halt_reason_e reason = TARGET_HALT_RUNNING;
+	while (reason == TARGET_HALT_RUNNING && !platform_timeout_is_expired(&timeout))
+		reason = target_halt_poll(target, NULL);
+	if (reason == TARGET_HALT_RUNNING || reason == TARGET_HALT_ERROR) {
+		DEBUG_ERROR("Failed to halt the target\n");
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Walk RAM with the reads GDB makes while the target is stopped. These go through the target read cache,
+ * and as the walk never revisits an address before the cache has been cycled, every read is a cold miss.
+ */
+static bool bench_mem_read_halted(target_s *const target, const target_ram_s *const ram)
+{
+	uint8_t data[BENCH_HALTED_READ_CHUNK];
+	const size_t window = ram->length - (ram->length % BENCH_HALTED_READ_CHUNK);
+	if (!window)
+		return true;
+	if (!bench_halt(target))
+		return false;
+
+	const uint64_t start = bmda_time_us();
+	size_t ops = 0;
+	bool result = true;
+	for (size_t total = 0; result && total < BENCH_MEM_READ_TOTAL; total += BENCH_HALTED_READ_CHUNK, ++ops)
+		result = !target_mem_read(target, data, ram->start + (total % window), BENCH_HALTED_READ_CHUNK);
+	if (result)
+		bench_report("m read halted", ops, BENCH_MEM_READ_TOTAL, bmda_time_us() - start);
+	else
+		DEBUG_ERROR("Halted memory read benchmark failed\n");
+	target_halt_resume(target, false);
+	return result;
+}
+
+static bool bench_regs_read(target_s *const target)
+{
+	uint8_t *const regs = malloc(target_regs_size(target));
+	if (!regs) { /* malloc failed: heap exhaustion */
+		DEBUG_ERROR("malloc: failed in %s\n", __func__);
+		return false;
+	}
+
+	/*
+	 * Drivers cache the registers for as long as the target stays halted, so halt and resume it around each
+	 * read to make every one go to the target, timing only the reads themselves
+	 */
+	uint64_t elapsed = 0U;
+	bool result = true;
+	for (size_t i = 0; result && i < BENCH_REGS_READS; ++i) {
+		result = bench_halt(target);
+		const uint64_t start = bmda_time_us();
+		target_regs_read(target, regs);
+		elapsed += bmda_time_us() - start;
+		target_halt_resume(target, false);
+	}
+	result = result && !target_check_error(target);
+	if (result)
+		bench_report("regs read", BENCH_REGS_READS, 0U, elapsed);
+	else
+		DEBUG_ERROR("Register read benchmark failed\n");
+	free(regs);
+	return result;
+}
+
+/*
+ * Mirrors the accesses one poll_rtt() pass makes with a single busy up channel: check the control
+ * block header, fetch the channel descriptors, read out the pending data and update the tail offset.
+ * The "control block" sits at the start of RAM.
+ */
+static bool bench_rtt_poll(target_s *const target, const target_ram_s *const ram)
+{
+	if (ram->length < BENCH_RTT_HEADER + BENCH_RTT_DESCRIPTORS + BENCH_RTT_DATA)
+		return true;
+
+	uint8_t data[BENCH_RTT_HEADER + BENCH_RTT_DESCRIPTORS + BENCH_RTT_DATA];
+	const target_addr_t descriptors = ram->start + BENCH_RTT_HEADER;
+	const target_addr_t buffer = descriptors + BENCH_RTT_DESCRIPTORS;
+	const uint32_t tail = 0;
+
+	const uint64_t start = bmda_time_us();
+	for (size_t i = 0; i < BENCH_RTT_POLLS; ++i) {
+		if (target_mem_read(target, data, ram->start, BENCH_RTT_HEADER) ||
+			target_mem_read(target, data, descriptors, BENCH_RTT_DESCRIPTORS) ||
+			target_mem_read(target, data, buffer, BENCH_RTT_DATA) ||
+			target_mem_write(target, descriptors + 16U, &tail, sizeof(tail))) {
+			DEBUG_ERROR("RTT poll benchmark failed\n");
+			return false;
+		}
+	}
+	bench_report("rtt poll", BENCH_RTT_POLLS, BENCH_RTT_POLLS * BENCH_RTT_DATA, bmda_time_us() - start);
+	return true;
+}
+
+bool bmda_bench(target_s *const target)
+{
+	const target_ram_s *const ram = target->ram;
+	if (!ram) {
+		DEBUG_ERROR("No RAM on target, can't run benchmarks\n");
+		return false;
+	}
+
+	DEBUG_WARN("Running benchmarks against %s\n", target_driver_name(target));
+	return bench_flash(target) && bench_mem_read(target, ram) && bench_mem_read_halted(target, ram) &&
+		bench_regs_read(target) && bench_rtt_poll(target, ram);
+}
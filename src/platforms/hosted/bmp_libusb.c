@@ -47,6 +47,7 @@ typedef int_least16_t char16_t;
 #include "probe_info.h"
 #include "utils.h"
 #include "hex_utils.h"
+#include "wire_trace.h"
 
 #define NO_SERIAL_NUMBER "<no serial number>"
 
@@ -578,7 +579,7 @@ int find_debuggers(bmda_cli_options_s *cl_opts, bmda_probe_s *info)
  *   sent/received may be less (per libusb's documentation). If used, rx_buffer must be
  *   suitably initialised up front to avoid UB reads when accessed.
  */
-int bmda_usb_transfer(
+static int bmda_usb_bulk_transfer(
 	usb_link_s *link, const void *tx_buffer, size_t tx_len, void *rx_buffer, size_t rx_len, uint16_t timeout)
 {
 	/* If there's data to send */
@@ -631,3 +632,14 @@ int bmda_usb_transfer(
 	}
 	return LIBUSB_SUCCESS;
 }
+
+/* Record each request/response exchange with the adaptor in the wire trace, the request length as the address */
+int bmda_usb_transfer(
+	usb_link_s *link, const void *tx_buffer, size_t tx_len, void *rx_buffer, size_t rx_len, uint16_t timeout)
+{
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
+	const int result = bmda_usb_bulk_transfer(link, tx_buffer, tx_len, rx_buffer, rx_len, timeout);
+	wire_trace_end(&mark, WIRE_TRACE_USB_TRANSFER, tx_len, result < 0 ? 0U : (uint32_t)result);
+	return result;
+}
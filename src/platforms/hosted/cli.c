@@ -36,6 +36,7 @@
 
 #include "cli.h"
 #include "bmp_hosted.h"
+#include "bench.h"
 
 #ifndef O_BINARY
 #define O_BINARY 0
@@ -129,9 +130,9 @@ static void cl_help(char **argv)
 {
 	bmp_ident(NULL);
 	DEBUG_INFO("\n"
-			   "Usage: %s [-h | -l | [-v BITMASK] [-O] [-d PATH | -P NUMBER | -s SERIAL | -c TYPE]\n"
-			   "\t[-n NUMBER] [-j | -A] [-C] [-t | -T] [-e] [-p] [-R[h]] [-H] [-M STRING ...]\n"
-			   "\t[-f | -m] [-E | -w | -V | -r] [-a ADDR] [-S number] [file]]\n"
+			   "Usage: %s [-h | -l | [-v BITMASK] [-O] [-d PATH | -P NUMBER | -s SERIAL | -c TYPE | -X[US]]\n"
+			   "\t[-n NUMBER] [-j | -A] [-C] [-t | -T] [-e] [-p] [-R[h]] [-H] [-M STRING ...] [-y FILE]\n"
+			   "\t[-f | -m] [-E | -w | -V | -r | -B] [-a ADDR] [-S number] [-z] [file]]\n"
 			   "\n"
 			   "The default is to start a debug server at localhost:2000\n\n"
 			   "Single-shot and verbosity options [-h | -l | -v BITMASK]:\n"
@@ -142,16 +143,18 @@ static void cl_help(char **argv)
 			   "\t-O, --no-stdout  Don't use stdout for debugging output, making it available\n"
 			   "\t                   for use by RTT, Semihosting, or other target output\n"
 			   "\n"
-			   "Probe selection arguments [-d PATH | -P NUMBER | -s SERIAL | -c TYPE]:\n"
+			   "Probe selection arguments [-d PATH | -P NUMBER | -s SERIAL | -c TYPE | -X[US]]:\n"
 			   "\t-d, --device     Use a serial device at the given path\n"
 			   "\t-P, --probe      Use the <number>th debug probe found while scanning the\n"
 			   "\t                   system, see the output from list for the order\n"
 			   "\t-s, --serial     Select the debug probe with the given serial number\n"
 			   "\t-c, --ftdi-type  Select the FTDI-based debug probe with of the given\n"
 			   "\t                   type (cable)\n"
+			   "\t-X, --sim        Use a simulated STM32F103 target instead of a probe, adding\n"
+			   "\t                   the given latency in microseconds to each link transaction\n"
 			   "\n"
 			   "General configuration options: [-n NUMBER] [-j] [-C] [-t | -T] [-e] [-p] [-R[h]]\n"
-			   "\t\t[-H] [-M STRING ...]\n"
+			   "\t\t[-H] [-M STRING ...] [-y FILE] [-Y FILE]\n"
 			   "\t-n, --number     Select the target device at the given position in the\n"
 			   "\t                   scan chain (use the -t option to get a scan chain listing)\n"
 			   "\t-j, --jtag       Use JTAG instead of SWD\n"
@@ -173,24 +176,35 @@ static void cl_help(char **argv)
 			   "\t                   can be repeated for as many commands you wish to run.\n"
 			   "\t                   If the command contains spaces, use quotes around the\n"
 			   "\t                   complete command\n"
+			   "\t-y, --trace      Record every probe transaction and its latency, printing a\n"
+			   "\t                   latency histogram on exit and writing a Chrome trace\n"
+			   "\t                   (Perfetto compatible) JSON file to the given path.\n"
+			   "\t                   \"monitor wire_trace\" does the same mid-session\n"
+			   "\t-Y, --replay     Feed a recorded GDB session (raw, or from GDB's remotelogfile)\n"
+			   "\t                   to the GDB server instead of listening for connections,\n"
+			   "\t                   printing the time and traffic spent per packet type\n"
 			   "\n"
 			   "SWD-specific configuration options [-f FREQUENCY | -m TARGET]:\n"
 			   "\t-f, --freq       Set an operating frequency for SWD\n"
 			   "\t-m, --mult-drop  Use the given target ID for selection in SWD multi-drop\n"
 			   "\n"
-			   "Flash operation selection options [-E | -w | -V | -r]:\n"
+			   "Flash operation selection options [-E | -w | -V | -r | -B]:\n"
 			   "\t-E, --erase      Erase the target device Flash\n"
 			   "\t-w, --write      Write the specified binary file to the target device\n"
 			   "\t                   Flash (the default)\n"
 			   "\t-V, --verify     Verify the target device Flash against the specified\n"
 			   "\t                   binary file\n"
 			   "\t-r, --read       Read the target device Flash\n"
+			   "\t-B, --bench      Benchmark Flash write and verify, memory reads, register\n"
+			   "\t                   reads and RTT polling. This overwrites the target Flash\n"
 			   "\n"
-			   "Flash operation modifiers options: [-a ADDR] [-S number] [FILE]\n"
+			   "Flash operation modifiers options: [-a ADDR] [-S number] [-z] [FILE]\n"
 			   "\t-a, --addr       Start address for the given Flash operation (defaults to\n"
 			   "\t                   the start of Flash)\n"
 			   "\t-S, --byte-count Number of bytes to work on in the Flash operation (default\n"
 			   "\t                   is till the operation fails or is complete)\n"
+			   "\t-z, --stats      Show Flash timing and link usage statistics for the\n"
+			   "\t                   operation once it completes\n"
 			   "\t<file>           Binary file to use in Flash operations\n",
 		argv[0]);
 	exit(0);
@@ -225,6 +239,11 @@ static const getopt_option_s long_options[] = {
 	{"read", no_argument, NULL, 'r'},
 	{"addr", required_argument, NULL, 'a'},
 	{"byte-count", required_argument, NULL, 'S'},
+	{"stats", no_argument, NULL, 'z'},
+	{"trace", required_argument, NULL, 'y'},
+	{"replay", required_argument, NULL, 'Y'},
+	{"sim", optional_argument, NULL, 'X'},
+	{"bench", no_argument, NULL, 'B'},
 	{NULL, 0, NULL, 0},
 };
 
@@ -237,7 +256,8 @@ void cl_init(bmda_cli_options_s *opt, int argc, char **argv)
 	opt->opt_scanmode = BMP_SCAN_SWD;
 	opt->opt_mode = BMP_MODE_DEBUG;
 	while (true) {
-		const int option = getopt_long(argc, argv, "eEFhHv:Od:f:s:I:c:Cln:m:M:wVtTa:S:jApP:rR::", long_options, NULL);
+		const int option =
+			getopt_long(argc, argv, "eEFhHv:Od:f:s:I:c:Cln:m:M:wVtTa:S:jApP:rR::zy:Y:X::B", long_options, NULL);
 		if (option == -1)
 			break;
 
@@ -351,6 +371,25 @@ void cl_init(bmda_cli_options_s *opt, int argc, char **argv)
 		case 'p':
 			opt->opt_tpwr = true;
 			break;
+		case 'z':
+			opt->opt_flash_stats = true;
+			break;
+		case 'X':
+			opt->opt_sim = true;
+			if (optarg)
+				opt->opt_sim_latency = strtoul(optarg, NULL, 0);
+			break;
+		case 'B':
+			opt->opt_mode = BMP_MODE_BENCH;
+			break;
+		case 'y':
+			if (optarg)
+				opt->opt_trace_file = optarg;
+			break;
+		case 'Y':
+			if (optarg)
+				opt->opt_replay_file = optarg;
+			break;
 		case 'a':
 			if (optarg)
 				opt->opt_flash_start = strtol(optarg, NULL, 0);
@@ -560,7 +599,10 @@ int cl_execute(bmda_cli_options_s *opt)
 	}
 	if (opt->opt_mode == BMP_MODE_RESET)
 		target_reset(target);
-	else if (opt->opt_mode == BMP_MODE_FLASH_ERASE) {
+	else if (opt->opt_mode == BMP_MODE_BENCH) {
+		if (!bmda_bench(target))
+			res = -1;
+	} else if (opt->opt_mode == BMP_MODE_FLASH_ERASE) {
 		DEBUG_INFO("Erase %zu bytes at 0x%08" PRIx32 "\n", opt->opt_flash_size, opt->opt_flash_start);
 		if (!target_flash_erase(target, opt->opt_flash_start, opt->opt_flash_size)) {
 			DEBUG_ERROR("Flash erase failed!\n");
@@ -645,6 +687,8 @@ int cl_execute(bmda_cli_options_s *opt)
 			target_reset(target);
 	}
 free_map:
+	if (opt->opt_flash_stats)
+		target_flash_stats_print(target);
 	if (map.size)
 		bmp_munmap(&map);
 target_detach:
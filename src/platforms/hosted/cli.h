@@ -38,6 +38,7 @@ typedef enum bmda_cli_mode {
 	BMP_MODE_FLASH_VERIFY,
 	BMP_MODE_SWJ_TEST,
 	BMP_MODE_MONITOR,
+	BMP_MODE_BENCH,
 } bmda_cli_mode_e;
 
 typedef enum bmp_scan_mode {
@@ -55,6 +56,8 @@ typedef struct bmda_cli_options {
 	bool external_resistor_swd;
 	bool fast_poll;
 	bool opt_no_hl;
+	bool opt_flash_stats;
+	bool opt_sim;
 	char *opt_flash_file;
 	char *opt_device;
 	char *opt_serial;
@@ -63,9 +66,12 @@ typedef struct bmda_cli_options {
 	size_t opt_position;
 	char *opt_cable;
 	char *opt_monitor;
+	char *opt_trace_file;
+	char *opt_replay_file;
 	uint32_t opt_target_dev;
 	uint32_t opt_flash_start;
 	uint32_t opt_max_swj_frequency;
+	uint32_t opt_sim_latency;
 	size_t opt_flash_size;
 } bmda_cli_options_s;
 
@@ -63,6 +63,7 @@ typedef int32_t socket_t;
 #include "gdb_if.h"
 #include "bmp_hosted.h"
 #include "command.h"
+#include "gdb_replay.h"
 
 #define DEFAULT_PORT 2000U
 static const uint16_t default_port = DEFAULT_PORT;
@@ -263,6 +264,8 @@ int gdb_if_init(void)
 
 char gdb_if_getchar(void)
 {
+	if (gdb_replay_active)
+		return gdb_replay_getchar();
 	if (gdb_if_conn == INVALID_SOCKET) {
 		if (shutdown_bmda)
 			return '\x04';
@@ -311,6 +314,8 @@ char gdb_if_getchar(void)
 
 char gdb_if_getchar_to(uint32_t timeout)
 {
+	if (gdb_replay_active)
+		return gdb_replay_getchar_to(timeout);
 	if (gdb_if_conn == INVALID_SOCKET)
 		return -1;
 
@@ -333,6 +338,10 @@ char gdb_if_getchar_to(uint32_t timeout)
 
 void gdb_if_putchar(char c, int flush)
 {
+	if (gdb_replay_active) {
+		gdb_replay_putchar(c);
+		return;
+	}
 	if (gdb_if_conn == INVALID_SOCKET)
 		return;
 	gdb_buffer[gdb_buffer_used++] = c;
@@ -0,0 +1,337 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2026 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements replaying a recorded GDB session into the GDB server in place of the TCP socket.
+ * The recording is either the raw byte stream GDB sent, or a log made with GDB's `set remotelogfile`,
+ * of which only the `w` (GDB to stub) lines are used. Each packet is timed from when its checksum has
+ * been consumed to when the next packet starts, so the time includes generating and sending the reply
+ * and any target communication done to make it. Together with the simulated target this gives a
+ * repeatable way to measure the cost of the GDB protocol handling per packet type. Target transactions
+ * are counted at the DP access layer, so register, DP and AP traffic is included along with memory accesses.
+ *
+ * As nothing is actually listening to the replies, ACKs are taken from the recording when the stub
+ * waits for one (assumed if the recording has none), and a running target is halted as soon as the
+ * stub polls for a break request.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "general.h"
+#include "gdb_replay.h"
+#include "command.h"
+#include "wire_trace.h"
+#include "utils.h"
+
+/* Maximum number of distinct packet types tracked */
+#define GDB_REPLAY_PACKET_TYPES 64U
+/* Maximum length of a packet type name, such as qXfer */
+#define GDB_REPLAY_NAME_LEN 24U
+
+typedef enum gdb_replay_state {
+	GDB_REPLAY_IDLE,
+	GDB_REPLAY_NAME,
+	GDB_REPLAY_PAYLOAD,
+	GDB_REPLAY_CHECKSUM,
+	GDB_REPLAY_HANDLING,
+} gdb_replay_state_e;
+
+typedef struct gdb_replay_stats {
+	char name[GDB_REPLAY_NAME_LEN];
+	uint64_t count;
+	uint64_t total_time;
+	uint64_t max_time;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	uint64_t transactions;
+} gdb_replay_stats_s;
+
+bool gdb_replay_active = false;
+
+static uint8_t *gdb_replay_data;
+static size_t gdb_replay_length;
+static size_t gdb_replay_offset;
+
+static gdb_replay_state_e gdb_replay_state;
+static char gdb_replay_name[GDB_REPLAY_NAME_LEN];
+static size_t gdb_replay_name_len;
+static size_t gdb_replay_checksum_len;
+static uint64_t gdb_replay_bytes_in;
+static uint64_t gdb_replay_bytes_out;
+static uint64_t gdb_replay_start;
+static uint64_t gdb_replay_run_start;
+static uint32_t gdb_replay_transactions;
+
+static gdb_replay_stats_s gdb_replay_stats[GDB_REPLAY_PACKET_TYPES];
+static size_t gdb_replay_types;
+
+static int gdb_replay_hex_digit(const uint8_t value)
+{
+	if (value >= '0' && value <= '9')
+		return value - '0';
+	if (value >= 'a' && value <= 'f')
+		return value - 'a' + 10;
+	if (value >= 'A' && value <= 'F')
+		return value - 'A' + 10;
+	return -1;
+}
+
+/* Decode the escaped payload of a remotelogfile line in place, returning the new length */
+static size_t gdb_replay_unescape(uint8_t *const line, const size_t length)
+{
+	size_t result = 0;
+	for (size_t offset = 0; offset < length; ++offset) {
+		uint8_t value = line[offset];
+		if (value == '\\' && offset + 1U < length) {
+			value = line[++offset];
+			switch (value) {
+			case 'b':
+				value = '\b';
+				break;
+			case 'f':
+				value = '\f';
+				break;
+			case 'n':
+				value = '\n';
+				break;
+			case 'r':
+				value = '\r';
+				break;
+			case 't':
+				value = '\t';
+				break;
+			case 'v':
+				value = '\v';
+				break;
+			case 'x':
+				if (offset + 2U < length) {
+					const int high = gdb_replay_hex_digit(line[offset + 1U]);
+					const int low = gdb_replay_hex_digit(line[offset + 2U]);
+					if (high >= 0 && low >= 0) {
+						value = (uint8_t)((high << 4U) | low);
+						offset += 2U;
+					}
+				}
+				break;
+			default:
+				break;
+			}
+		}
+		line[result++] = value;
+	}
+	return result;
+}
+
+/* Reduce a remotelogfile recording to just the bytes GDB wrote */
+static void gdb_replay_parse_log(void)
+{
+	size_t length = 0;
+	for (size_t offset = 0; offset < gdb_replay_length;) {
+		const uint8_t *const end = memchr(gdb_replay_data + offset, '\n', gdb_replay_length - offset);
+		const size_t line_end = end ? (size_t)(end - gdb_replay_data) : gdb_replay_length;
+		if (line_end - offset > 2U && gdb_replay_data[offset] == 'w' && gdb_replay_data[offset + 1U] == ' ') {
+			const size_t line_length = gdb_replay_unescape(gdb_replay_data + offset + 2U, line_end - offset - 2U);
+			memmove(gdb_replay_data + length, gdb_replay_data + offset + 2U, line_length);
+			length += line_length;
+		}
+		offset = line_end + 1U;
+	}
+	gdb_replay_length = length;
+}
+
+bool gdb_replay_init(const char *const filename)
+{
+	FILE *const file = fopen(filename, "rb");
+	if (!file) {
+		DEBUG_ERROR("Could not open %s to replay\n", filename);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	const long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size <= 0) {
+		DEBUG_ERROR("Replay file %s is empty\n", filename);
+		fclose(file);
+		return false;
+	}
+	/* Load the whole recording up front so file I/O doesn't end up in the timings */
+	gdb_replay_data = malloc((size_t)size);
+	if (!gdb_replay_data) { /* malloc failed: heap exhaustion */
+		DEBUG_ERROR("malloc: failed in %s\n", __func__);
+		fclose(file);
+		return false;
+	}
+	gdb_replay_length = fread(gdb_replay_data, 1, (size_t)size, file);
+	fclose(file);
+
+	if (gdb_replay_length >= 2U && (gdb_replay_data[0] == 'w' || gdb_replay_data[0] == 'r') &&
+		gdb_replay_data[1] == ' ')
+		gdb_replay_parse_log();
+	DEBUG_WARN("Replaying %zu bytes of GDB session from %s\n", gdb_replay_length, filename);
+	gdb_replay_state = GDB_REPLAY_IDLE;
+	gdb_replay_run_start = bmda_time_us();
+	gdb_replay_active = true;
+	return true;
+}
+
+static gdb_replay_stats_s *gdb_replay_find_stats(void)
+{
+	for (size_t index = 0; index < gdb_replay_types; ++index) {
+		if (strcmp(gdb_replay_stats[index].name, gdb_replay_name) == 0)
+			return &gdb_replay_stats[index];
+	}
+	/* Lump anything past the table's capacity into its last entry */
+	if (gdb_replay_types == GDB_REPLAY_PACKET_TYPES)
+		return &gdb_replay_stats[GDB_REPLAY_PACKET_TYPES - 1U];
+	gdb_replay_stats_s *const stats = &gdb_replay_stats[gdb_replay_types++];
+	memcpy(stats->name, gdb_replay_name, sizeof(stats->name));
+	return stats;
+}
+
+/* Account the packet whose handling just finished to its packet type */
+static void gdb_replay_packet_done(void)
+{
+	if (gdb_replay_state != GDB_REPLAY_HANDLING)
+		return;
+	const uint64_t time = bmda_time_us() - gdb_replay_start;
+	gdb_replay_stats_s *const stats = gdb_replay_find_stats();
+	++stats->count;
+	stats->total_time += time;
+	stats->max_time = MAX(stats->max_time, time);
+	stats->bytes_in += gdb_replay_bytes_in;
+	stats->bytes_out += gdb_replay_bytes_out;
+	stats->transactions += wire_trace_dp_accesses - gdb_replay_transactions;
+	gdb_replay_state = GDB_REPLAY_IDLE;
+}
+
+/* Track packet framing over the bytes handed to the GDB server */
+static void gdb_replay_consume(const uint8_t value)
+{
+	if (value == '$') {
+		gdb_replay_packet_done();
+		gdb_replay_state = GDB_REPLAY_NAME;
+		gdb_replay_name_len = 0;
+		gdb_replay_bytes_in = 1;
+		return;
+	}
+	if (gdb_replay_state == GDB_REPLAY_IDLE || gdb_replay_state == GDB_REPLAY_HANDLING)
+		return;
+	++gdb_replay_bytes_in;
+
+	if (gdb_replay_state == GDB_REPLAY_CHECKSUM) {
+		if (++gdb_replay_checksum_len == 2U) {
+			gdb_replay_state = GDB_REPLAY_HANDLING;
+			gdb_replay_bytes_out = 0;
+			gdb_replay_transactions = wire_trace_dp_accesses;
+			gdb_replay_start = bmda_time_us();
+		}
+		return;
+	}
+	if (value == '#') {
+		gdb_replay_name[gdb_replay_name_len] = '\0';
+		gdb_replay_state = GDB_REPLAY_CHECKSUM;
+		gdb_replay_checksum_len = 0;
+		return;
+	}
+	if (gdb_replay_state != GDB_REPLAY_NAME)
+		return;
+	/* Query and vCont style packets are named up to their first separator, everything else by their first letter */
+	const bool named = gdb_replay_name_len && strchr("qQv", gdb_replay_name[0]) != NULL;
+	if ((gdb_replay_name_len == 0 || (named && isalnum(value))) && gdb_replay_name_len < GDB_REPLAY_NAME_LEN - 1U)
+		gdb_replay_name[gdb_replay_name_len++] = (char)value;
+	else {
+		gdb_replay_name[gdb_replay_name_len] = '\0';
+		gdb_replay_state = GDB_REPLAY_PAYLOAD;
+	}
+}
+
+char gdb_replay_getchar(void)
+{
+	if (gdb_replay_offset == gdb_replay_length) {
+		/* End of the recording, have the GDB server shut down as if the connection was closed */
+		gdb_replay_packet_done();
+		shutdown_bmda = true;
+		return '\x04';
+	}
+	const uint8_t value = gdb_replay_data[gdb_replay_offset++];
+	gdb_replay_consume(value);
+	return (char)value;
+}
+
+char gdb_replay_getchar_to(const uint32_t timeout)
+{
+	/* A zero timeout is the break request poll while the target runs, so halt it straight away */
+	if (!timeout) {
+		if (gdb_replay_offset < gdb_replay_length && gdb_replay_data[gdb_replay_offset] == '\x03')
+			++gdb_replay_offset;
+		return '\x03';
+	}
+	/*
+	 * Otherwise we are waiting on an ACK, which is consumed if the recording has one next. Recordings
+	 * don't always have an ACK for every reply (such as for console output), so treat those as ACK'd
+	 * rather than having the reply resent until it times out.
+	 */
+	if (gdb_replay_offset < gdb_replay_length &&
+		(gdb_replay_data[gdb_replay_offset] == '+' || gdb_replay_data[gdb_replay_offset] == '-'))
+		return gdb_replay_getchar();
+	return '+';
+}
+
+void gdb_replay_putchar(const char c)
+{
+	(void)c;
+	++gdb_replay_bytes_out;
+}
+
+void gdb_replay_finish(void)
+{
+	if (!gdb_replay_active)
+		return;
+	gdb_replay_active = false;
+	gdb_replay_packet_done();
+	const uint64_t run_time = bmda_time_us() - gdb_replay_run_start;
+
+	DEBUG_WARN("GDB replay: %zu of %zu bytes consumed in %" PRIu64 "us\n", gdb_replay_offset, gdb_replay_length,
+		run_time);
+	DEBUG_WARN("%-16s %8s %10s %9s %9s %10s %10s %9s\n", "Packet", "Count", "Total us", "Mean us", "Max us",
+		"Bytes in", "Bytes out", "Trans");
+	for (size_t index = 0; index < gdb_replay_types; ++index) {
+		const gdb_replay_stats_s *const stats = &gdb_replay_stats[index];
+		DEBUG_WARN("%-16s %8" PRIu64 " %10" PRIu64 " %9" PRIu64 " %9" PRIu64 " %10" PRIu64 " %10" PRIu64
+				   " %9" PRIu64 "\n",
+			stats->name, stats->count, stats->total_time, stats->total_time / stats->count, stats->max_time,
+			stats->bytes_in, stats->bytes_out, stats->transactions);
+	}
+	free(gdb_replay_data);
+	gdb_replay_data = NULL;
+}
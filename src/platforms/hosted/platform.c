@@ -46,6 +46,9 @@
 
 #include "bmp_remote.h"
 #include "bmp_hosted.h"
+#include "wire_trace.h"
+#include "gdb_replay.h"
+#include "sim.h"
 #if HOSTED_BMP_ONLY == 0
 #include "stlinkv2.h"
 #include "ftdi_bmp.h"
@@ -92,6 +95,8 @@ static void exit_function(void)
 	if (bmda_probe_info.libusb_ctx)
 		libusb_exit(bmda_probe_info.libusb_ctx);
 #endif
+	gdb_replay_finish();
+	wire_trace_finish();
 	fflush(stdout);
 }
 
@@ -109,10 +114,14 @@ void platform_init(int argc, char **argv)
 #endif
 	cl_init(&cl_opts, argc, argv);
 	atexit(exit_function);
+	if (cl_opts.opt_trace_file && !wire_trace_init(cl_opts.opt_trace_file))
+		exit(1);
 	signal(SIGTERM, sigterm_handler);
 	signal(SIGINT, sigterm_handler);
 
-	if (cl_opts.opt_device)
+	if (cl_opts.opt_sim)
+		bmda_probe_info.type = PROBE_TYPE_SIM;
+	else if (cl_opts.opt_device)
 		bmda_probe_info.type = PROBE_TYPE_BMP;
 	else if (find_debuggers(&cl_opts, &bmda_probe_info))
 		exit(1);
@@ -128,6 +137,11 @@ void platform_init(int argc, char **argv)
 			exit(1);
 		break;
 
+	case PROBE_TYPE_SIM:
+		if (!sim_init(cl_opts.opt_sim_latency))
+			exit(1);
+		break;
+
 #if HOSTED_BMP_ONLY == 0
 	case PROBE_TYPE_STLINK_V2:
 		if (!stlink_init())
@@ -157,7 +171,11 @@ void platform_init(int argc, char **argv)
 	if (cl_opts.opt_mode != BMP_MODE_DEBUG)
 		exit(cl_execute(&cl_opts));
 	else {
-		gdb_if_init();
+		if (cl_opts.opt_replay_file) {
+			if (!gdb_replay_init(cl_opts.opt_replay_file))
+				exit(1);
+		} else
+			gdb_if_init();
 
 #ifdef ENABLE_RTT
 		rtt_if_init();
@@ -177,6 +195,9 @@ bool bmda_swd_scan(const uint32_t targetid)
 	case PROBE_TYPE_JLINK:
 		return adiv5_swd_scan(targetid);
 
+	case PROBE_TYPE_SIM:
+		return sim_swd_scan();
+
 #if HOSTED_BMP_ONLY == 0
 	case PROBE_TYPE_STLINK_V2:
 		return stlink_swd_scan();
@@ -280,6 +301,14 @@ void bmda_adiv5_dp_init(adiv5_debug_port_s *const dp)
 		remote_adiv5_dp_init(dp);
 		break;
 
+	case PROBE_TYPE_SIM:
+		if (cl_opts.opt_no_hl) {
+			DEBUG_WARN("Not using HL commands\n");
+			break;
+		}
+		sim_adiv5_dp_init(dp);
+		break;
+
 #if HOSTED_BMP_ONLY == 0
 	case PROBE_TYPE_STLINK_V2:
 		stlink_adiv5_dp_init(dp);
@@ -334,6 +363,9 @@ char *bmda_adaptor_ident(void)
 	case PROBE_TYPE_JLINK:
 		return "J-Link";
 
+	case PROBE_TYPE_SIM:
+		return "Simulator";
+
 	default:
 		return NULL;
 	}
@@ -441,6 +473,9 @@ void platform_max_frequency_set(uint32_t freq)
 		break;
 #endif
 
+	case PROBE_TYPE_SIM:
+		break;
+
 	default:
 		DEBUG_WARN("Setting max SWD/JTAG frequency not yet implemented\n");
 		break;
@@ -476,6 +511,9 @@ uint32_t platform_max_frequency_get(void)
 		return jlink_max_frequency_get();
 #endif
 
+	case PROBE_TYPE_SIM:
+		return FREQ_FIXED;
+
 	default:
 		DEBUG_WARN("Reading max SWJ frequency not yet implemented\n");
 		return 0;
@@ -679,16 +717,30 @@ static void decode_access(const uint16_t addr, const uint8_t rnw, const uint8_t
 		decode_dp_access(addr & 0xffU, rnw, value);
 }
 
+static wire_trace_event_e adiv5_trace_event(const uint16_t addr, const uint8_t rnw)
+{
+	if (addr & ADIV5_APnDP)
+		return rnw ? WIRE_TRACE_AP_READ : WIRE_TRACE_AP_WRITE;
+	return rnw ? WIRE_TRACE_DP_READ : WIRE_TRACE_DP_WRITE;
+}
+
 bool adiv5_write_no_check(adiv5_debug_port_s *dp, uint16_t addr, const uint32_t value)
 {
 	decode_access(addr, ADIV5_LOW_WRITE, 0U, value);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", value);
-	return dp->write_no_check(addr, value);
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
+	const bool result = dp->write_no_check(addr, value);
+	wire_trace_end(&mark, adiv5_trace_event(addr, ADIV5_LOW_WRITE), addr, sizeof(value));
+	return result;
 }
 
 uint32_t adiv5_read_no_check(adiv5_debug_port_s *dp, uint16_t addr)
 {
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	uint32_t result = dp->read_no_check(addr);
+	wire_trace_end(&mark, adiv5_trace_event(addr, ADIV5_LOW_READ), addr, sizeof(result));
 	decode_access(addr, ADIV5_LOW_READ, 0U, 0U);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", result);
 	return result;
@@ -698,12 +750,18 @@ void adiv5_dp_write(adiv5_debug_port_s *dp, uint16_t addr, uint32_t value)
 {
 	decode_access(addr, ADIV5_LOW_WRITE, 0U, value);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", value);
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	dp->low_access(dp, ADIV5_LOW_WRITE, addr, value);
+	wire_trace_end(&mark, adiv5_trace_event(addr, ADIV5_LOW_WRITE), addr, sizeof(value));
 }
 
 uint32_t adiv5_dp_read(adiv5_debug_port_s *dp, uint16_t addr)
 {
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	uint32_t ret = dp->dp_read(dp, addr);
+	wire_trace_end(&mark, WIRE_TRACE_DP_READ, addr, sizeof(ret));
 	decode_access(addr, ADIV5_LOW_READ, 0U, 0U);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", ret);
 	return ret;
@@ -718,7 +776,10 @@ uint32_t adiv5_dp_error(adiv5_debug_port_s *dp)
 
 uint32_t adiv5_dp_low_access(adiv5_debug_port_s *dp, uint8_t rnw, uint16_t addr, uint32_t value)
 {
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	uint32_t ret = dp->low_access(dp, rnw, addr, value);
+	wire_trace_end(&mark, adiv5_trace_event(addr, rnw), addr, sizeof(ret));
 	decode_access(addr, rnw, 0U, value);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", rnw ? ret : value);
 	return ret;
@@ -726,7 +787,10 @@ uint32_t adiv5_dp_low_access(adiv5_debug_port_s *dp, uint8_t rnw, uint16_t addr,
 
 uint32_t adiv5_ap_read(adiv5_access_port_s *ap, uint16_t addr)
 {
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	uint32_t ret = ap->dp->ap_read(ap, addr);
+	wire_trace_end(&mark, WIRE_TRACE_AP_READ, ((uint32_t)ap->apsel << 24U) | addr, sizeof(ret));
 	decode_access(addr, ADIV5_LOW_READ, ap->apsel, 0U);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", ret);
 	return ret;
@@ -736,12 +800,18 @@ void adiv5_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value)
 {
 	decode_access(addr, ADIV5_LOW_WRITE, ap->apsel, value);
 	DEBUG_PROTO("0x%08" PRIx32 "\n", value);
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	ap->dp->ap_write(ap, addr, value);
+	wire_trace_end(&mark, WIRE_TRACE_AP_WRITE, ((uint32_t)ap->apsel << 24U) | addr, sizeof(value));
 }
 
 void adiv5_mem_read(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t len)
 {
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	ap->dp->mem_read(ap, dest, src, len);
+	wire_trace_end(&mark, WIRE_TRACE_MEM_READ, src, len);
 	DEBUG_PROTO("ap_memread @ %" PRIx32 " len %zu:", src, len);
 	const uint8_t *const data = (const uint8_t *)dest;
 	for (size_t offset = 0; offset < len; ++offset) {
@@ -766,7 +836,10 @@ void adiv5_mem_write_sized(adiv5_access_port_s *ap, uint32_t dest, const void *s
 	if (len > 16U)
 		DEBUG_PROTO(" ...");
 	DEBUG_PROTO("\n");
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	ap->dp->mem_write(ap, dest, src, len, align);
+	wire_trace_end(&mark, WIRE_TRACE_MEM_WRITE, dest, len);
 }
 
 void adiv5_dp_abort(adiv5_debug_port_s *dp, uint32_t abort)
@@ -31,6 +31,7 @@
 #include "bmp_hosted.h"
 #include "utils.h"
 #include "cortexm.h"
+#include "wire_trace.h"
 
 #define READ_BUFFER_LENGTH 4096U
 
@@ -218,7 +219,10 @@ void serial_close(void)
 bool platform_buffer_write(const void *const data, const size_t length)
 {
 	DEBUG_WIRE("%s\n", (const char *)data);
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	const ssize_t written = write(fd, data, length);
+	wire_trace_end(&mark, WIRE_TRACE_SERIAL_WRITE, 0U, length);
 	if (written < 0) {
 		const int error = errno;
 		DEBUG_ERROR("Failed to write (%d): %s\n", errno, strerror(error));
@@ -266,7 +270,7 @@ static ssize_t bmda_read_more_data(void)
 
 /* XXX: We should either return size_t or bool */
 /* XXX: This needs documenting that it can abort the program with exit(), or the error handling fixed */
-int platform_buffer_read(void *const data, const size_t length)
+static int bmda_buffer_read(void *const data, const size_t length)
 {
 	char *const buffer = (char *)data;
 	/* Drain the buffer for the remote till we see a start-of-response byte */
@@ -310,3 +314,12 @@ int platform_buffer_read(void *const data, const size_t length)
 	}
 	return length;
 }
+
+int platform_buffer_read(void *const data, const size_t length)
+{
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
+	const int result = bmda_buffer_read(data, length);
+	wire_trace_end(&mark, WIRE_TRACE_SERIAL_READ, 0U, result < 0 ? 0U : (uint32_t)result);
+	return result;
+}
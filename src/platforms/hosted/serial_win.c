@@ -21,6 +21,7 @@
 #include <windows.h>
 #include "remote.h"
 #include "cli.h"
+#include "wire_trace.h"
 
 #include <assert.h>
 #include <string.h>
@@ -238,6 +239,8 @@ bool platform_buffer_write(const void *const data, const size_t length)
 {
 	const char *const buffer = (const char *)data;
 	DEBUG_WIRE("%s\n", buffer);
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
 	DWORD written = 0;
 	for (size_t offset = 0; offset < length; offset += written) {
 		if (!WriteFile(port_handle, buffer + offset, length - offset, &written, NULL)) {
@@ -245,6 +248,7 @@ bool platform_buffer_write(const void *const data, const size_t length)
 			return false;
 		}
 	}
+	wire_trace_end(&mark, WIRE_TRACE_SERIAL_WRITE, 0U, length);
 	return true;
 }
 
@@ -269,7 +273,7 @@ static ssize_t bmda_read_more_data(const uint32_t end_time)
 
 /* XXX: We should either return size_t or bool */
 /* XXX: This needs documenting that it can abort the program with exit(), or the error handling fixed */
-int platform_buffer_read(void *const data, const size_t length)
+static int bmda_buffer_read(void *const data, const size_t length)
 {
 	char *const buffer = (char *)data;
 	const uint32_t start_time = platform_time_ms();
@@ -320,3 +324,12 @@ int platform_buffer_read(void *const data, const size_t length)
 	}
 	return length;
 }
+
+int platform_buffer_read(void *const data, const size_t length)
+{
+	wire_trace_mark_s mark;
+	wire_trace_begin(&mark);
+	const int result = bmda_buffer_read(data, length);
+	wire_trace_end(&mark, WIRE_TRACE_SERIAL_READ, 0U, result < 0 ? 0U : (uint32_t)result);
+	return result;
+}
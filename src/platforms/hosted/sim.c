@@ -0,0 +1,588 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2026 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements a simulated probe and target for BMDA so the ADIv5 and Flash layers can be
+ * exercised and benchmarked without any hardware attached. It models an SW-DP and AHB-AP in front of an
+ * STM32F103 medium density part (Cortex-M3, 128 KiB Flash, 20 KiB SRAM) with enough of the core debug
+ * registers, ROM tables and Flash controller for the regular Cortex-M and STM32F1 drivers to work.
+ * Each DP/AP transaction (or high-level memory transfer) costs a configurable amount of latency to
+ * stand in for the probe link.
+ *
+ * The simulated core does not execute code: once resumed it idles until halted again.
+ */
+
+#include "general.h"
+#include "sim.h"
+#include "utils.h"
+#include "target_internal.h"
+#include "cortexm.h"
+#include "buffer_utils.h"
+
+#define SIM_DPIDR        0x1ba01477U
+#define SIM_AP_IDR       0x14770011U
+#define SIM_AP_CSW_RESET 0x03000040U
+#define SIM_AP_BASE      (SIM_ROM_BASE | 3U)
+
+#define SIM_ROM_BASE      0xe00ff000U
+#define SIM_ROM_MEMTYPE   (SIM_ROM_BASE + 0xfccU)
+#define SIM_ROM_SCS_ENTRY 0xfff0f003U
+#define SIM_CPUID         0x411fc231U
+#define SIM_IDCODE        0x20036410U
+#define SIM_DBGMCU_IDCODE 0xe0042000U
+
+#define SIM_FLASH_BASE 0x08000000U
+#define SIM_FLASH_SIZE 0x20000U
+#define SIM_FLASH_PAGE 0x400U
+#define SIM_SRAM_BASE  0x20000000U
+#define SIM_SRAM_SIZE  0x5000U
+
+#define SIM_FPEC_BASE 0x40022000U
+#define SIM_FPEC_KEYR (SIM_FPEC_BASE + 0x04U)
+#define SIM_FPEC_SR   (SIM_FPEC_BASE + 0x0cU)
+#define SIM_FPEC_CR   (SIM_FPEC_BASE + 0x10U)
+#define SIM_FPEC_AR   (SIM_FPEC_BASE + 0x14U)
+#define SIM_FPEC_KEY1 0x45670123U
+#define SIM_FPEC_KEY2 0xcdef89abU
+
+#define SIM_FPEC_CR_PG   (1U << 0U)
+#define SIM_FPEC_CR_PER  (1U << 1U)
+#define SIM_FPEC_CR_MER  (1U << 2U)
+#define SIM_FPEC_CR_STRT (1U << 6U)
+#define SIM_FPEC_CR_LOCK (1U << 7U)
+
+#define SIM_FPEC_SR_PGERR (1U << 2U)
+#define SIM_FPEC_SR_EOP   (1U << 5U)
+#define SIM_FPEC_SR_W1C   0x34U
+
+#define SIM_DP_CTRLSTAT_PWRUPREQ (ADIV5_DP_CTRLSTAT_CSYSPWRUPREQ | ADIV5_DP_CTRLSTAT_CDBGPWRUPREQ)
+#define SIM_DP_CTRLSTAT_PWRUPACK (ADIV5_DP_CTRLSTAT_CSYSPWRUPACK | ADIV5_DP_CTRLSTAT_CDBGPWRUPACK)
+#define SIM_DP_CTRLSTAT_STICKY                                                                  \
+	(ADIV5_DP_CTRLSTAT_STICKYORUN | ADIV5_DP_CTRLSTAT_STICKYCMP | ADIV5_DP_CTRLSTAT_STICKYERR | \
+		ADIV5_DP_CTRLSTAT_WDATAERR)
+
+/* Core register file size, enough to cover the FPU registers at DCRSR index 0x40-0x5f */
+#define SIM_CORE_REGS 0x60U
+/* Number of bytes a high-level memory transfer moves per simulated link round trip */
+#define SIM_HL_CHUNK 1024U
+
+typedef struct sim_state {
+	uint32_t latency_us;
+
+	/* SW-DP */
+	uint32_t ctrlstat;
+	uint32_t select;
+	uint32_t rdbuff;
+
+	/* AHB-AP */
+	uint32_t csw;
+	uint32_t tar;
+
+	/* Core debug */
+	bool halted;
+	bool reset_status;
+	uint32_t dhcsr;
+	uint32_t dfsr;
+	uint32_t dcrdr;
+	uint32_t demcr;
+	uint32_t regs[SIM_CORE_REGS];
+
+	/* Flash program and erase controller */
+	uint8_t fpec_keys;
+	uint32_t fpec_cr;
+	uint32_t fpec_sr;
+	uint32_t fpec_ar;
+
+	uint8_t flash[SIM_FLASH_SIZE];
+	uint8_t sram[SIM_SRAM_SIZE];
+} sim_state_s;
+
+static sim_state_s sim;
+
+/* PIDR4-7, PIDR0-3 and CIDR0-3 (low byte of each) for the ROM table and the SCS */
+static const uint8_t sim_rom_ids[12] = {0x00, 0, 0, 0, 0x10, 0x04, 0x0a, 0x00, 0x0d, 0x10, 0x05, 0xb1};
+static const uint8_t sim_scs_ids[12] = {0x04, 0, 0, 0, 0x00, 0xb0, 0x0b, 0x00, 0x0d, 0xe0, 0x05, 0xb1};
+
+static void sim_link_delay(const size_t round_trips)
+{
+	if (!sim.latency_us)
+		return;
+	/* Spin rather than sleep as the OS sleep granularity is far coarser than a typical probe round trip */
+	const uint64_t end = bmda_time_us() + ((uint64_t)sim.latency_us * round_trips);
+	while (bmda_time_us() < end)
+		continue;
+}
+
+static void sim_core_reset(void)
+{
+	memset(sim.regs, 0, sizeof(sim.regs));
+	sim.regs[13] = read_le4(sim.flash, 0U);
+	sim.regs[15] = read_le4(sim.flash, 4U) & ~1U;
+	sim.regs[CORTEXM_DCRSR_REGSEL_XPSR] = CORTEXM_XPSR_THUMB;
+	sim.regs[CORTEXM_DCRSR_REGSEL_MSP] = sim.regs[13];
+	sim.reset_status = true;
+	sim.halted = sim.demcr & CORTEXM_DEMCR_VC_CORERESET;
+	if (sim.halted)
+		sim.dfsr |= CORTEXM_DFSR_VCATCH;
+	sim.fpec_keys = 0U;
+	sim.fpec_cr = SIM_FPEC_CR_LOCK;
+	sim.fpec_sr = 0U;
+}
+
+static uint32_t sim_id_read(const uint8_t *const ids, const uint32_t offset)
+{
+	if (offset < 0xfd0U)
+		return 0U;
+	return ids[(offset - 0xfd0U) >> 2U];
+}
+
+static uint32_t sim_dhcsr_read(void)
+{
+	uint32_t dhcsr = sim.dhcsr | CORTEXM_DHCSR_S_REGRDY;
+	if (sim.halted)
+		dhcsr |= CORTEXM_DHCSR_S_HALT;
+	/* S_RESET_ST is sticky until read */
+	if (sim.reset_status)
+		dhcsr |= CORTEXM_DHCSR_S_RESET_ST;
+	sim.reset_status = false;
+	return dhcsr;
+}
+
+static void sim_dhcsr_write(const uint32_t value)
+{
+	if ((value & 0xffff0000U) != CORTEXM_DHCSR_DBGKEY)
+		return;
+	sim.dhcsr = value & (CORTEXM_DHCSR_C_MASKINTS | CORTEXM_DHCSR_C_STEP | CORTEXM_DHCSR_C_HALT |
+							CORTEXM_DHCSR_C_DEBUGEN);
+	if (value & CORTEXM_DHCSR_C_HALT) {
+		if (!sim.halted)
+			sim.dfsr |= CORTEXM_DFSR_HALTED;
+		sim.halted = true;
+	} else if (value & CORTEXM_DHCSR_C_STEP) {
+		/* Every simulated instruction is a 16-bit no-op */
+		sim.regs[15] += 2U;
+		sim.dfsr |= CORTEXM_DFSR_HALTED;
+		sim.halted = true;
+	} else
+		sim.halted = false;
+}
+
+static void sim_dcrsr_write(const uint32_t value)
+{
+	const uint32_t regsel = value & 0x7fU;
+	if (regsel >= SIM_CORE_REGS)
+		return;
+	if (value & CORTEXM_DCRSR_REGWnR)
+		sim.regs[regsel] = sim.dcrdr;
+	else
+		sim.dcrdr = sim.regs[regsel];
+}
+
+/* Reads the aligned 32-bit word containing addr from the simulated system bus */
+static uint32_t sim_bus_read(const uint32_t addr)
+{
+	const uint32_t word = addr & ~3U;
+	if (word >= SIM_FLASH_BASE && word < SIM_FLASH_BASE + SIM_FLASH_SIZE)
+		return read_le4(sim.flash, word - SIM_FLASH_BASE);
+	if (word >= SIM_SRAM_BASE && word < SIM_SRAM_BASE + SIM_SRAM_SIZE)
+		return read_le4(sim.sram, word - SIM_SRAM_BASE);
+	if ((word & 0xfffff000U) == SIM_ROM_BASE) {
+		if (word == SIM_ROM_BASE)
+			return SIM_ROM_SCS_ENTRY;
+		if (word == SIM_ROM_MEMTYPE)
+			return 1U;
+		return sim_id_read(sim_rom_ids, word - SIM_ROM_BASE);
+	}
+	if ((word & 0xfffff000U) == CORTEXM_SCS_BASE) {
+		switch (word) {
+		case CORTEXM_CPUID:
+			return SIM_CPUID;
+		case CORTEXM_AIRCR:
+			return 0xfa050000U;
+		case CORTEXM_DFSR:
+			return sim.dfsr;
+		case CORTEXM_DHCSR:
+			return sim_dhcsr_read();
+		case CORTEXM_DCRDR:
+			return sim.dcrdr;
+		case CORTEXM_DEMCR:
+			return sim.demcr;
+		default:
+			return sim_id_read(sim_scs_ids, word - CORTEXM_SCS_BASE);
+		}
+	}
+	switch (word) {
+	case SIM_DBGMCU_IDCODE:
+		return SIM_IDCODE;
+	case SIM_FPEC_SR:
+		return sim.fpec_sr;
+	case SIM_FPEC_CR:
+		return sim.fpec_cr;
+	case SIM_FPEC_AR:
+		return sim.fpec_ar;
+	default:
+		/* Everything else is read-as-zero */
+		return 0U;
+	}
+}
+
+static void sim_fpec_cr_write(const uint32_t value)
+{
+	if (sim.fpec_cr & SIM_FPEC_CR_LOCK)
+		return;
+	sim.fpec_cr = value & ~SIM_FPEC_CR_STRT;
+	if (!(value & SIM_FPEC_CR_STRT))
+		return;
+	/* Erase operations complete immediately so the benchmarks measure the link rather than the part */
+	if (value & SIM_FPEC_CR_MER)
+		memset(sim.flash, 0xff, sizeof(sim.flash));
+	else if ((value & SIM_FPEC_CR_PER) && sim.fpec_ar >= SIM_FLASH_BASE &&
+		sim.fpec_ar < SIM_FLASH_BASE + SIM_FLASH_SIZE)
+		memset(sim.flash + ((sim.fpec_ar - SIM_FLASH_BASE) & ~(SIM_FLASH_PAGE - 1U)), 0xff, SIM_FLASH_PAGE);
+	sim.fpec_sr |= SIM_FPEC_SR_EOP;
+}
+
+static void sim_flash_program(const uint32_t offset, const uint16_t value)
+{
+	const uint16_t current = read_le2(sim.flash, offset);
+	/* Like the real part, a half-word may only be programmed when erased, or cleared to 0 */
+	if (current != 0xffffU && value != 0U) {
+		sim.fpec_sr |= SIM_FPEC_SR_PGERR | SIM_FPEC_SR_EOP;
+		return;
+	}
+	write_le2(sim.flash, offset, value);
+	sim.fpec_sr |= SIM_FPEC_SR_EOP;
+}
+
+/* Writes a 1, 2 or 4 byte value held in its byte lanes of value (as on the AHB-AP DRW) to the system bus */
+static bool sim_bus_write(const uint32_t addr, const uint32_t value, const size_t size)
+{
+	const uint32_t lane_shift = (addr & 3U) * 8U;
+	if (addr >= SIM_SRAM_BASE && addr + size <= SIM_SRAM_BASE + SIM_SRAM_SIZE) {
+		for (size_t i = 0; i < size; ++i)
+			sim.sram[addr - SIM_SRAM_BASE + i] = (value >> (lane_shift + (i * 8U))) & 0xffU;
+		return true;
+	}
+	if (addr >= SIM_FLASH_BASE && addr + size <= SIM_FLASH_BASE + SIM_FLASH_SIZE) {
+		/* Flash only accepts half-word writes, and only while programming is enabled */
+		if (!(sim.fpec_cr & SIM_FPEC_CR_PG) || size == 1U || (addr & 1U))
+			return false;
+		for (size_t i = 0; i < size; i += 2U)
+			sim_flash_program(addr - SIM_FLASH_BASE + i, (value >> (lane_shift + (i * 8U))) & 0xffffU);
+		return true;
+	}
+
+	const uint32_t word = addr & ~3U;
+	const uint32_t data = value >> lane_shift;
+	switch (word) {
+	case CORTEXM_AIRCR:
+		if ((data & 0xffff0000U) == CORTEXM_AIRCR_VECTKEY && (data & CORTEXM_AIRCR_SYSRESETREQ))
+			sim_core_reset();
+		break;
+	case CORTEXM_DFSR:
+		sim.dfsr &= ~data;
+		break;
+	case CORTEXM_DHCSR:
+		sim_dhcsr_write(data);
+		break;
+	case CORTEXM_DCRSR:
+		sim_dcrsr_write(data);
+		break;
+	case CORTEXM_DCRDR:
+		sim.dcrdr = data;
+		break;
+	case CORTEXM_DEMCR:
+		sim.demcr = data;
+		break;
+	case SIM_FPEC_KEYR:
+		if (data == SIM_FPEC_KEY1)
+			sim.fpec_keys = 1U;
+		else if (data == SIM_FPEC_KEY2 && sim.fpec_keys == 1U) {
+			sim.fpec_keys = 0U;
+			sim.fpec_cr &= ~SIM_FPEC_CR_LOCK;
+		} else
+			sim.fpec_keys = 0U;
+		break;
+	case SIM_FPEC_SR:
+		sim.fpec_sr &= ~(data & SIM_FPEC_SR_W1C);
+		break;
+	case SIM_FPEC_CR:
+		sim_fpec_cr_write(data);
+		break;
+	case SIM_FPEC_AR:
+		sim.fpec_ar = data;
+		break;
+	default:
+		/* Everything else is write-ignored */
+		break;
+	}
+	return true;
+}
+
+static void sim_bus_error(void)
+{
+	sim.ctrlstat |= ADIV5_DP_CTRLSTAT_STICKYERR;
+}
+
+static uint32_t sim_ap_drw_size(void)
+{
+	switch (sim.csw & ADIV5_AP_CSW_SIZE_MASK) {
+	case ADIV5_AP_CSW_SIZE_BYTE:
+		return 1U;
+	case ADIV5_AP_CSW_SIZE_HALFWORD:
+		return 2U;
+	default:
+		return 4U;
+	}
+}
+
+static void sim_ap_drw_increment(void)
+{
+	/* TAR auto-increment is only guaranteed within a 1 KiB block, so wrap like real hardware does */
+	if ((sim.csw & ADIV5_AP_CSW_ADDRINC_MASK) == ADIV5_AP_CSW_ADDRINC_SINGLE)
+		sim.tar = (sim.tar & 0xfffffc00U) | ((sim.tar + sim_ap_drw_size()) & 0x3ffU);
+}
+
+static uint32_t sim_ap_read(const uint8_t apsel, const uint8_t reg)
+{
+	/* Only AP 0 exists, all others read as zero making them invalid */
+	if (apsel != 0U)
+		return 0U;
+	switch (reg) {
+	case 0x00U:
+		return sim.csw | ADIV5_AP_CSW_DEVICEEN;
+	case 0x04U:
+		return sim.tar;
+	case 0x0cU: {
+		const uint32_t value = sim_bus_read(sim.tar);
+		sim_ap_drw_increment();
+		return value;
+	}
+	case 0x10U:
+	case 0x14U:
+	case 0x18U:
+	case 0x1cU:
+		return sim_bus_read((sim.tar & ~0xfU) | (reg & 0xcU));
+	case 0xf8U:
+		return SIM_AP_BASE;
+	case 0xfcU:
+		return SIM_AP_IDR;
+	default:
+		return 0U;
+	}
+}
+
+static void sim_ap_write(const uint8_t apsel, const uint8_t reg, const uint32_t value)
+{
+	if (apsel != 0U)
+		return;
+	switch (reg) {
+	case 0x00U:
+		sim.csw = value & ~ADIV5_AP_CSW_DEVICEEN;
+		break;
+	case 0x04U:
+		sim.tar = value;
+		break;
+	case 0x0cU: {
+		const uint32_t size = sim_ap_drw_size();
+		if (!sim_bus_write(sim.tar & ~(size - 1U), value, size))
+			sim_bus_error();
+		sim_ap_drw_increment();
+		break;
+	}
+	case 0x10U:
+	case 0x14U:
+	case 0x18U:
+	case 0x1cU:
+		if (!sim_bus_write((sim.tar & ~0xfU) | (reg & 0xcU), value, 4U))
+			sim_bus_error();
+		break;
+	default:
+		break;
+	}
+}
+
+static uint32_t sim_dp_register_read(const uint8_t reg)
+{
+	switch (reg) {
+	case 0x0U:
+		return SIM_DPIDR;
+	case 0x4U:
+		/* The power domains acknowledge their requests immediately */
+		return (sim.ctrlstat & ~SIM_DP_CTRLSTAT_PWRUPACK) | ((sim.ctrlstat & SIM_DP_CTRLSTAT_PWRUPREQ) << 1U);
+	default:
+		/* RESEND and RDBUFF both return the result of the last AP read */
+		return sim.rdbuff;
+	}
+}
+
+static void sim_dp_register_write(const uint8_t reg, const uint32_t value)
+{
+	switch (reg) {
+	case 0x0U:
+		if (value & ADIV5_DP_ABORT_ORUNERRCLR)
+			sim.ctrlstat &= ~ADIV5_DP_CTRLSTAT_STICKYORUN;
+		if (value & ADIV5_DP_ABORT_WDERRCLR)
+			sim.ctrlstat &= ~ADIV5_DP_CTRLSTAT_WDATAERR;
+		if (value & ADIV5_DP_ABORT_STKERRCLR)
+			sim.ctrlstat &= ~ADIV5_DP_CTRLSTAT_STICKYERR;
+		if (value & ADIV5_DP_ABORT_STKCMPCLR)
+			sim.ctrlstat &= ~ADIV5_DP_CTRLSTAT_STICKYCMP;
+		break;
+	case 0x4U:
+		sim.ctrlstat = (value & ~(SIM_DP_CTRLSTAT_PWRUPACK | SIM_DP_CTRLSTAT_STICKY)) |
+			(sim.ctrlstat & SIM_DP_CTRLSTAT_STICKY);
+		break;
+	case 0x8U:
+		sim.select = value;
+		break;
+	default:
+		break;
+	}
+}
+
+static uint32_t sim_low_access(
+	adiv5_debug_port_s *const dp, const uint8_t rnw, const uint16_t addr, const uint32_t value)
+{
+	(void)dp;
+	sim_link_delay(1U);
+	if (addr & ADIV5_APnDP) {
+		const uint8_t apsel = sim.select >> 24U;
+		const uint8_t reg = (sim.select & 0xf0U) | (addr & 0x0cU);
+		if (!rnw) {
+			sim_ap_write(apsel, reg, value);
+			return 0U;
+		}
+		/* AP reads are posted: the result arrives with the next AP or RDBUFF read */
+		const uint32_t result = sim.rdbuff;
+		sim.rdbuff = sim_ap_read(apsel, reg);
+		return result;
+	}
+	if (rnw)
+		return sim_dp_register_read(addr & 0x0cU);
+	sim_dp_register_write(addr & 0x0cU, value);
+	return 0U;
+}
+
+static uint32_t sim_dp_error(adiv5_debug_port_s *const dp, const bool protocol_recovery)
+{
+	(void)protocol_recovery;
+	const uint32_t err = sim_low_access(dp, ADIV5_LOW_READ, ADIV5_DP_CTRLSTAT, 0U) & SIM_DP_CTRLSTAT_STICKY;
+	if (err)
+		sim_low_access(dp, ADIV5_LOW_WRITE, ADIV5_DP_ABORT,
+			ADIV5_DP_ABORT_ORUNERRCLR | ADIV5_DP_ABORT_WDERRCLR | ADIV5_DP_ABORT_STKERRCLR |
+				ADIV5_DP_ABORT_STKCMPCLR);
+	dp->fault = 0;
+	return err;
+}
+
+static void sim_dp_abort(adiv5_debug_port_s *const dp, const uint32_t abort)
+{
+	sim_low_access(dp, ADIV5_LOW_WRITE, ADIV5_DP_ABORT, abort);
+}
+
+static void sim_mem_read(adiv5_access_port_s *const ap, void *const dest, const uint32_t src, const size_t len)
+{
+	(void)ap;
+	sim_link_delay((len + SIM_HL_CHUNK - 1U) / SIM_HL_CHUNK);
+	uint8_t *const data = (uint8_t *)dest;
+	for (size_t offset = 0; offset < len;) {
+		const uint32_t addr = src + offset;
+		/* Read each bus word once so registers with read side effects behave */
+		const uint32_t value = sim_bus_read(addr);
+		for (uint32_t lane = addr & 3U; lane < 4U && offset < len; ++lane, ++offset)
+			data[offset] = (value >> (lane * 8U)) & 0xffU;
+	}
+}
+
+static void sim_mem_write(
+	adiv5_access_port_s *const ap, const uint32_t dest, const void *const src, const size_t len, const align_e align)
+{
+	(void)ap;
+	sim_link_delay((len + SIM_HL_CHUNK - 1U) / SIM_HL_CHUNK);
+	const uint8_t *const data = (const uint8_t *)src;
+	const size_t width = 1U << align;
+	size_t size = width;
+	for (size_t offset = 0; offset < len; offset += size) {
+		/* Any trailing partial unit is written out a byte at a time */
+		size = len - offset >= width ? width : 1U;
+		const uint32_t addr = dest + offset;
+		uint32_t value = 0;
+		for (size_t i = 0; i < size; ++i)
+			value |= (uint32_t)data[offset + i] << (((addr + i) & 3U) * 8U);
+		if (!sim_bus_write(addr, value, size))
+			sim_bus_error();
+	}
+}
+
+bool sim_init(const uint32_t latency_us)
+{
+	memset(&sim, 0, sizeof(sim));
+	sim.latency_us = latency_us;
+	sim.csw = SIM_AP_CSW_RESET;
+	memset(sim.flash, 0xff, sizeof(sim.flash));
+	sim_core_reset();
+	sim.reset_status = false;
+
+	strncpy(bmda_probe_info.manufacturer, "Black Magic Debug", sizeof(bmda_probe_info.manufacturer) - 1U);
+	strncpy(bmda_probe_info.product, "Simulated STM32F103", sizeof(bmda_probe_info.product) - 1U);
+	snprintf(bmda_probe_info.version, sizeof(bmda_probe_info.version), "%" PRIu32 "us link latency", latency_us);
+	DEBUG_INFO("Using simulated target with %" PRIu32 "us link latency\n", latency_us);
+	return true;
+}
+
+bool sim_swd_scan(void)
+{
+	target_list_free();
+
+	adiv5_debug_port_s *dp = calloc(1, sizeof(*dp));
+	if (!dp) { /* calloc failed: heap exhaustion */
+		DEBUG_ERROR("calloc: failed in %s\n", __func__);
+		return false;
+	}
+
+	dp->dp_read = firmware_swdp_read;
+	dp->error = sim_dp_error;
+	dp->low_access = sim_low_access;
+	dp->abort = sim_dp_abort;
+
+	adiv5_dp_error(dp);
+	adiv5_dp_init(dp);
+
+	return target_list != NULL;
+}
+
+void sim_adiv5_dp_init(adiv5_debug_port_s *const dp)
+{
+	dp->mem_read = sim_mem_read;
+	dp->mem_write = sim_mem_write;
+}
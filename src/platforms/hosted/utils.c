@@ -31,6 +31,7 @@
 #include "general.h"
 #include "timing.h"
 #include "bmp_hosted.h"
+#include "utils.h"
 
 #if defined(_WIN32) && !defined(__MINGW32__)
 int vasprintf(char **strp, const char *const fmt, va_list ap)
@@ -66,6 +67,13 @@ uint32_t platform_time_ms(void)
 	return (tv.tv_sec * 1000U) + (tv.tv_usec / 1000U);
 }
 
+uint64_t bmda_time_us(void)
+{
+	timeval_s tv;
+	gettimeofday(&tv, NULL);
+	return ((uint64_t)tv.tv_sec * 1000000U) + (uint64_t)tv.tv_usec;
+}
+
 bool begins_with(const char *const str, const size_t str_length, const char *const value)
 {
 	const size_t value_length = strlen(value);
@@ -41,5 +41,6 @@
 bool begins_with(const char *str, size_t str_length, const char *value);
 bool ends_with(const char *str, size_t str_length, const char *value);
 bool contains_substring(const char *str, size_t str_len, const char *search);
+uint64_t bmda_time_us(void);
 
 #endif /* PLATFORMS_HOSTED_UTILS_H */
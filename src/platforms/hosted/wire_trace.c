@@ -0,0 +1,239 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2026 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This file implements a low-overhead binary trace of the traffic BMDA generates to talk to the probe.
+ * Each debug port access, probe transfer and high-level target operation is recorded with its latency
+ * into a ring buffer, and aggregated into a per-event latency histogram. On exit, or on demand with
+ * "monitor wire_trace", the histogram is printed and the ring buffer is written out as a Chrome trace
+ * (JSON) file which can be loaded into Perfetto or chrome://tracing to find chatty code paths.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "general.h"
+#include "gdb_packet.h"
+#include "bmp_hosted.h"
+#include "wire_trace.h"
+#include "utils.h"
+
+/* Number of records the ring buffer keeps, 6 MiB worth */
+#define WIRE_TRACE_RECORDS 262144U
+/* Number of log2 latency buckets, the first being < 1us and the last >= 16ms */
+#define WIRE_TRACE_BUCKETS 16U
+
+typedef struct wire_trace_record {
+	uint64_t start;
+	uint32_t duration;
+	uint32_t address;
+	uint32_t length;
+	uint16_t round_trips;
+	uint8_t event;
+} wire_trace_record_s;
+
+typedef struct wire_trace_summary {
+	uint64_t count;
+	uint64_t total_time;
+	uint64_t round_trips;
+	uint32_t max_time;
+	uint64_t buckets[WIRE_TRACE_BUCKETS];
+} wire_trace_summary_s;
+
+static const char *const wire_trace_event_names[WIRE_TRACE_EVENT_COUNT] = {
+	"dp_read",
+	"dp_write",
+	"ap_read",
+	"ap_write",
+	"mem_read",
+	"mem_write",
+	"usb_transfer",
+	"serial_write",
+	"serial_read",
+	"target_mem_read",
+	"target_mem_write",
+	"target_regs_read",
+	"target_halt_poll",
+};
+
+bool wire_trace_active = false;
+uint32_t wire_trace_dp_accesses = 0;
+
+static const char *wire_trace_filename;
+static wire_trace_record_s *wire_trace_records;
+static size_t wire_trace_next;
+static bool wire_trace_wrapped;
+static uint32_t wire_trace_round_trips;
+static wire_trace_summary_s wire_trace_summaries[WIRE_TRACE_EVENT_COUNT];
+
+bool wire_trace_init(const char *const filename)
+{
+	wire_trace_records = calloc(WIRE_TRACE_RECORDS, sizeof(*wire_trace_records));
+	if (!wire_trace_records) { /* calloc failed: heap exhaustion */
+		DEBUG_ERROR("calloc: failed in %s\n", __func__);
+		return false;
+	}
+	wire_trace_filename = filename;
+	wire_trace_active = true;
+	return true;
+}
+
+void wire_trace_begin(wire_trace_mark_s *const mark)
+{
+	if (!wire_trace_active)
+		return;
+	mark->start = bmda_time_us();
+	mark->round_trips = wire_trace_round_trips;
+}
+
+void wire_trace_end(const wire_trace_mark_s *const mark, const wire_trace_event_e event, const uint32_t address,
+	const uint32_t length)
+{
+	if (event <= WIRE_TRACE_MEM_WRITE)
+		++wire_trace_dp_accesses;
+	if (!wire_trace_active)
+		return;
+	const uint32_t duration = (uint32_t)(bmda_time_us() - mark->start);
+	/* Each USB transfer and each response read from a BMP is one turnaround with the probe */
+	if (event == WIRE_TRACE_USB_TRANSFER || event == WIRE_TRACE_SERIAL_READ)
+		++wire_trace_round_trips;
+	const uint32_t round_trips = wire_trace_round_trips - mark->round_trips;
+
+	wire_trace_record_s *const record = &wire_trace_records[wire_trace_next];
+	record->start = mark->start;
+	record->duration = duration;
+	record->address = address;
+	record->length = length;
+	record->round_trips = (uint16_t)MIN(round_trips, UINT16_MAX);
+	record->event = (uint8_t)event;
+	if (++wire_trace_next == WIRE_TRACE_RECORDS) {
+		wire_trace_next = 0;
+		wire_trace_wrapped = true;
+	}
+
+	wire_trace_summary_s *const summary = &wire_trace_summaries[event];
+	++summary->count;
+	summary->total_time += duration;
+	summary->round_trips += round_trips;
+	summary->max_time = MAX(summary->max_time, duration);
+	size_t bucket = 0;
+	for (uint32_t value = duration; value && bucket < WIRE_TRACE_BUCKETS - 1U; value >>= 1U)
+		++bucket;
+	++summary->buckets[bucket];
+}
+
+/* Print a line of the histogram either to the GDB console or to BMDA's own output */
+static void wire_trace_print(const bool to_gdb, const char *const fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void wire_trace_print(const bool to_gdb, const char *const fmt, ...)
+{
+	char buffer[384];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(buffer, sizeof(buffer), fmt, args);
+	va_end(args);
+	if (to_gdb)
+		gdb_out(buffer);
+	else
+		DEBUG_WARN("%s", buffer);
+}
+
+static void wire_trace_print_histogram(const bool to_gdb)
+{
+	wire_trace_print(
+		to_gdb, "Wire trace latency histogram (us, log2 buckets from <1 to >=%u):\n", 1U << (WIRE_TRACE_BUCKETS - 2U));
+	for (size_t event = 0; event < WIRE_TRACE_EVENT_COUNT; ++event) {
+		const wire_trace_summary_s *const summary = &wire_trace_summaries[event];
+		if (!summary->count)
+			continue;
+		wire_trace_print(to_gdb, "%-17s %9" PRIu64 " calls, mean %6" PRIu64 "us, max %7" PRIu32 "us",
+			wire_trace_event_names[event], summary->count, summary->total_time / summary->count, summary->max_time);
+		/* Operations also get their mean number of probe round trips */
+		if (event >= WIRE_TRACE_OP_MEM_READ)
+			wire_trace_print(to_gdb, ", %6.2f round trips", (double)summary->round_trips / (double)summary->count);
+		/* Each bucket count is at most 20 digits and a separator */
+		char row[WIRE_TRACE_BUCKETS * 21U + 1U];
+		size_t offset = 0;
+		for (size_t bucket = 0; bucket < WIRE_TRACE_BUCKETS; ++bucket)
+			offset += (size_t)snprintf(row + offset, sizeof(row) - offset, " %" PRIu64, summary->buckets[bucket]);
+		wire_trace_print(to_gdb, "\n %s\n", row);
+	}
+}
+
+static void wire_trace_write_file(void)
+{
+	FILE *const file = fopen(wire_trace_filename, "w");
+	if (!file) {
+		DEBUG_ERROR("Could not open %s to write the wire trace\n", wire_trace_filename);
+		return;
+	}
+	const size_t count = wire_trace_wrapped ? WIRE_TRACE_RECORDS : wire_trace_next;
+	const size_t first = wire_trace_wrapped ? wire_trace_next : 0U;
+	const uint64_t base = count ? wire_trace_records[first].start : 0U;
+	fputs("{\"traceEvents\":[\n", file);
+	for (size_t index = 0; index < count; ++index) {
+		const wire_trace_record_s *const record = &wire_trace_records[(first + index) % WIRE_TRACE_RECORDS];
+		/* Put operations, debug port accesses and probe transfers on their own tracks */
+		const unsigned track = record->event >= WIRE_TRACE_OP_MEM_READ ? 1U :
+			record->event >= WIRE_TRACE_USB_TRANSFER                   ? 3U :
+																		 2U;
+		fprintf(file,
+			"%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%" PRIu64 ",\"dur\":%" PRIu32
+			",\"args\":{\"address\":\"0x%08" PRIx32 "\",\"length\":%" PRIu32 ",\"round_trips\":%u}}",
+			index ? ",\n" : "", wire_trace_event_names[record->event], track, record->start - base, record->duration,
+			record->address, record->length, record->round_trips);
+	}
+	fputs("\n]}\n", file);
+	fclose(file);
+	DEBUG_WARN("Wrote %zu wire trace records to %s\n", count, wire_trace_filename);
+}
+
+void wire_trace_finish(void)
+{
+	if (!wire_trace_active)
+		return;
+	wire_trace_active = false;
+	wire_trace_print_histogram(false);
+	wire_trace_write_file();
+	free(wire_trace_records);
+	wire_trace_records = NULL;
+}
+
+bool wire_trace_dump(void)
+{
+	if (!wire_trace_active)
+		return false;
+	wire_trace_print_histogram(true);
+	wire_trace_write_file();
+	gdb_outf("Wire trace written to %s\n", wire_trace_filename);
+	return true;
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of the Black Magic Debug project.
+ *
+ * Copyright (C) 2026 1BitSquared <info@1bitsquared.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PLATFORMS_HOSTED_WIRE_TRACE_H
+#define PLATFORMS_HOSTED_WIRE_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Trace event kinds. The low-level entries record individual debug port accesses and transfers
+ * to and from the probe, while the operation entries record the high-level requests they were
+ * made on behalf of along with how many probe round trips each one took.
+ */
+typedef enum wire_trace_event {
+	WIRE_TRACE_DP_READ,
+	WIRE_TRACE_DP_WRITE,
+	WIRE_TRACE_AP_READ,
+	WIRE_TRACE_AP_WRITE,
+	WIRE_TRACE_MEM_READ,
+	WIRE_TRACE_MEM_WRITE,
+	WIRE_TRACE_USB_TRANSFER,
+	WIRE_TRACE_SERIAL_WRITE,
+	WIRE_TRACE_SERIAL_READ,
+	WIRE_TRACE_OP_MEM_READ,
+	WIRE_TRACE_OP_MEM_WRITE,
+	WIRE_TRACE_OP_REGS_READ,
+	WIRE_TRACE_OP_HALT_POLL,
+	WIRE_TRACE_EVENT_COUNT,
+} wire_trace_event_e;
+
+typedef struct wire_trace_mark {
+	uint64_t start;
+	uint32_t round_trips;
+} wire_trace_mark_s;
+
+extern bool wire_trace_active;
+/* Number of DP, AP and MEM-AP level accesses made, counted whether or not tracing is active */
+extern uint32_t wire_trace_dp_accesses;
+
+bool wire_trace_init(const char *filename);
+void wire_trace_begin(wire_trace_mark_s *mark);
+void wire_trace_end(const wire_trace_mark_s *mark, wire_trace_event_e event, uint32_t address, uint32_t length);
+void wire_trace_finish(void);
+/* Print the histogram to GDB and write out the trace so far, leaving tracing running */
+bool wire_trace_dump(void);
+
+#endif /* PLATFORMS_HOSTED_WIRE_TRACE_H */
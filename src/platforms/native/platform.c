@@ -42,6 +42,9 @@
 static void adc_init(void);
 static void setup_vbus_irq(void);
 
+void trace_dma_isr(void);
+void usbusart2_dma_rx_isr(void);
+
 /* This is defined by the linker script */
 extern char vector_table;
 
@@ -525,6 +528,15 @@ void exti15_10_isr(void)
 	exti_reset_request(usb_vbus_pin);
 }
 
+/* DMA1 channel 6 carries the SWO capture on hardware 5 and older and the aux serial RX from hardware 6 on */
+void dma1_channel6_isr(void)
+{
+	if (platform_hwversion() < 6)
+		TRACE_DMA_ISR();
+	else
+		USBUSART2_DMA_RX_ISR();
+}
+
 static void setup_vbus_irq(void)
 {
 	uint32_t usb_vbus_port;
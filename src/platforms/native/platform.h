@@ -281,13 +281,24 @@ extern bool debug_bmp;
 #define USBUSART2_DMA_TX_ISR(x) dma1_channel7_isr(x)
 #define USBUSART2_DMA_RX_CHAN   DMA_CHANNEL6
 #define USBUSART2_DMA_RX_IRQ    NVIC_DMA1_CHANNEL6_IRQ
-#define USBUSART2_DMA_RX_ISR(x) dma1_channel6_isr(x)
+#define USBUSART2_DMA_RX_ISR(x) usbusart2_dma_rx_isr(x)
 
 #define TRACE_TIM          TIM3
 #define TRACE_TIM_CLK_EN() rcc_periph_clock_enable(RCC_TIM3)
 #define TRACE_IRQ          NVIC_TIM3_IRQ
 #define TRACE_ISR(x)       tim3_isr(x)
 
+/*
+ * TIM3_CH1 DMA requests go to DMA1 channel 6, which hardware 6 and newer need for the aux serial RX,
+ * so the vector is shared and dispatched in platform.c. Those revisions decode SWO edge by edge.
+ */
+#define TRACE_DMA_BUS         DMA1
+#define TRACE_DMA_CLK         RCC_DMA1
+#define TRACE_DMA_CHAN        DMA_CHANNEL6
+#define TRACE_DMA_IRQ         NVIC_DMA1_CHANNEL6_IRQ
+#define TRACE_DMA_ISR(x)      trace_dma_isr(x)
+#define TRACE_DMA_AVAILABLE() (platform_hwversion() < 6)
+
 #define SET_RUN_STATE(state)   running_status = (state)
 #define SET_IDLE_STATE(state)  gpio_set_val(LED_PORT, LED_IDLE_RUN, state)
 #define SET_ERROR_STATE(state) gpio_set_val(LED_PORT, LED_ERROR, state)
@@ -80,7 +80,10 @@ extern bool debug_bmp;
 #define MCO1_AF   0
 
 #define PLATFORM_HAS_TRACESWO 1
-#define NUM_TRACE_PACKETS     (16)
+/* Trace capture ring buffer, 128 packets of 512 bytes = 64kiB of the F723's 256kiB SRAM */
+#ifndef NUM_TRACE_PACKETS
+#define NUM_TRACE_PACKETS 128U
+#endif
 #define TRACESWO_PROTOCOL     2 /* 1 = Manchester, 2 = NRZ / async */
 
 #define SWDIO_MODE_REG      GPIO_MODER(TMS_PORT)
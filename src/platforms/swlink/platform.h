@@ -57,7 +57,9 @@ extern bool debug_bmp;
 #define LED_UART      GPIO14
 
 #define PLATFORM_HAS_TRACESWO 1
-#define NUM_TRACE_PACKETS     128U /* This is an 8K buffer */
+#ifndef NUM_TRACE_PACKETS
+#define NUM_TRACE_PACKETS 128U /* This is an 8K buffer */
+#endif
 #define TRACESWO_PROTOCOL     2U   /* 1 = Manchester, 2 = NRZ / async */
 
 #define SWD_CR      GPIO_CRH(SWDIO_PORT)
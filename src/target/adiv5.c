@@ -48,9 +48,13 @@
 /*
  * This value is taken from the ADIv5 spec table C1-2
  * "AP Identification types for an AP designed by Arm"
- * §C1.3 pg146. This defines a AHB3 AP when the class value is 8
+ * §C1.3 pg146. These define the AHB and AXI (system bus) APs when the class value is 8
  */
-#define ARM_AP_TYPE_AHB3 1U
+#define ARM_AP_TYPE_AHB3       1U
+#define ARM_AP_TYPE_AXI3_4     4U
+#define ARM_AP_TYPE_AHB5       5U
+#define ARM_AP_TYPE_AXI5       7U
+#define ARM_AP_TYPE_AHB5_HPROT 8U
 
 /* ROM table CIDR values */
 #define CIDR0_OFFSET 0xff0U /* DBGCID0 */
@@ -794,6 +798,42 @@ static void adiv5_dp_clear_sticky_errors(adiv5_debug_port_s *dp)
 		adiv5_dp_error(dp);
 }
 
+/*
+ * Note an Arm AHB or AXI MEM-AP with no Cortex-M behind it as a candidate for direct system memory access.
+ * AXI-APs are kept ahead of AHB-APs as the latter are more often a companion core's private bus.
+ */
+static void adiv5_dp_note_system_ap(adiv5_debug_port_s *const dp, const adiv5_access_port_s *const ap)
+{
+	uint16_t designer = ADIV5_AP_IDR_DESIGNER(ap->idr);
+	designer = (designer & ADIV5_DP_DESIGNER_JEP106_CONT_MASK) << 1U | (designer & ADIV5_DP_DESIGNER_JEP106_CODE_MASK);
+	if (designer != JEP106_MANUFACTURER_ARM || ADIV5_AP_IDR_CLASS(ap->idr) != 8U ||
+		dp->system_ap_count == ADIV5_DP_MAX_SYSTEM_APS)
+		return;
+	const uint8_t ap_type = ADIV5_AP_IDR_TYPE(ap->idr);
+	const bool axi = ap_type == ARM_AP_TYPE_AXI3_4 || ap_type == ARM_AP_TYPE_AXI5;
+	if (!axi && ap_type != ARM_AP_TYPE_AHB3 && ap_type != ARM_AP_TYPE_AHB5 && ap_type != ARM_AP_TYPE_AHB5_HPROT)
+		return;
+	const size_t slot = axi ? dp->system_ap_axi_count++ : dp->system_ap_count;
+	memmove(dp->system_apsel + slot + 1U, dp->system_apsel + slot, dp->system_ap_count - slot);
+	dp->system_apsel[slot] = ap->apsel;
+	++dp->system_ap_count;
+}
+
+/*
+ * Get a new reference to the best system MEM-AP candidate noted during the DP's AP scan,
+ * or NULL if there wasn't one or none of them can be brought back up.
+ */
+adiv5_access_port_s *adiv5_find_system_ap(adiv5_debug_port_s *const dp)
+{
+	for (size_t i = 0; i < dp->system_ap_count; ++i) {
+		adiv5_access_port_s *const ap = adiv5_new_ap(dp, dp->system_apsel[i]);
+		if (ap)
+			return ap;
+		adiv5_dp_clear_sticky_errors(dp);
+	}
+	return NULL;
+}
+
 /* Keep the TRY_CATCH funkiness contained to avoid clobbering and reduce the need for volatiles */
 uint32_t adiv5_dp_read_dpidr(adiv5_debug_port_s *const dp)
 {
@@ -981,10 +1021,11 @@ void adiv5_dp_init(adiv5_debug_port_s *const dp)
 		 * Having completed discovery on this AP, if we're not in connect-under-reset mode,
 		 * and now that we're done with this AP's ROM tables, look for the target and resume the core.
 		 */
+		bool ap_has_target = false;
 		for (target_s *target = target_list; target; target = target->next) {
-			if (!connect_assert_nrst && target->priv_free == cortex_priv_free) {
-				adiv5_access_port_s *target_ap = cortex_ap(target);
-				if (target_ap == ap)
+			if (target->priv_free == cortex_priv_free && cortex_ap(target) == ap) {
+				ap_has_target = true;
+				if (!connect_assert_nrst)
 					target_halt_resume(target, false);
 			}
 
@@ -999,6 +1040,8 @@ void adiv5_dp_init(adiv5_debug_port_s *const dp)
 				return;
 			}
 		}
+		if (!ap_has_target)
+			adiv5_dp_note_system_ap(dp, ap);
 		adiv5_ap_unref(ap);
 	}
 	adiv5_dp_unref(dp);
@@ -1141,6 +1184,44 @@ void adiv5_mem_write_bytes(adiv5_access_port_s *ap, uint32_t dest, const void *s
 	adiv5_dp_read(ap->dp, ADIV5_DP_RDBUFF);
 }
 
+/*
+ * Read the same 32-bit location count times without address increment, for draining FIFO-like registers
+ * such as a debug communications channel. Where we know how the DP returns posted reads, they are chained
+ * so each word only costs one AP access, with the last collected from RDBUFF.
+ */
+void adiv5_mem_read_fifo(adiv5_access_port_s *const ap, uint32_t *const dest, const uint32_t src, const size_t count)
+{
+	if (!count)
+		return;
+	adiv5_debug_port_s *const dp = ap->dp;
+	adiv5_ap_write(ap, ADIV5_AP_CSW, ap->csw | ADIV5_AP_CSW_ADDRINC_NONE | ADIV5_AP_CSW_SIZE_WORD);
+	adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, src);
+	if (dp->dp_read != firmware_swdp_read && dp->dp_read != fw_adiv5_jtagdp_read) {
+		for (size_t i = 0; i < count; ++i)
+			dest[i] = adiv5_dp_read(dp, ADIV5_AP_DRW);
+		return;
+	}
+	adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
+	for (size_t i = 1; i < count; ++i)
+		dest[i - 1U] = adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_AP_DRW, 0);
+	dest[count - 1U] = adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+}
+
+/* Write count words to the same 32-bit location without address increment, the counterpart to the above */
+void adiv5_mem_write_fifo(
+	adiv5_access_port_s *const ap, const uint32_t dest, const uint32_t *const src, const size_t count)
+{
+	if (!count)
+		return;
+	adiv5_debug_port_s *const dp = ap->dp;
+	adiv5_ap_write(ap, ADIV5_AP_CSW, ap->csw | ADIV5_AP_CSW_ADDRINC_NONE | ADIV5_AP_CSW_SIZE_WORD);
+	adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_TAR, dest);
+	for (size_t i = 0; i < count; ++i)
+		adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_DRW, src[i]);
+	/* Make sure the last write is complete by doing a dummy read */
+	adiv5_dp_read(dp, ADIV5_DP_RDBUFF);
+}
+
 void firmware_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value)
 {
 	adiv5_dp_recoverable_access(
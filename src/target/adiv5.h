@@ -224,6 +224,8 @@
 #define SWDP_ACK_FAULT       0x04U
 #define SWDP_ACK_NO_RESPONSE 0x07U
 
+#define ADIV5_DP_MAX_SYSTEM_APS 4U
+
 typedef struct adiv5_access_port adiv5_access_port_s;
 typedef struct adiv5_debug_port adiv5_debug_port_s;
 
@@ -268,6 +270,11 @@ struct adiv5_debug_port {
 	/* TARGETID designer and partno, present on DPv2 */
 	uint16_t target_designer_code;
 	uint16_t target_partno;
+
+	/* MEM-APs seen during the AP scan that might give direct access to system memory, AXI-APs first */
+	uint8_t system_ap_count;
+	uint8_t system_ap_axi_count;
+	uint8_t system_apsel[ADIV5_DP_MAX_SYSTEM_APS];
 };
 
 struct adiv5_access_port {
@@ -381,6 +388,7 @@ adiv5_access_port_s *adiv5_new_ap(adiv5_debug_port_s *dp, uint8_t apsel);
 void remote_jtag_dev(const jtag_dev_s *jtag_dev);
 void adiv5_ap_ref(adiv5_access_port_s *ap);
 void adiv5_ap_unref(adiv5_access_port_s *ap);
+adiv5_access_port_s *adiv5_find_system_ap(adiv5_debug_port_s *dp);
 void bmda_add_jtag_dev(uint32_t dev_index, const jtag_dev_s *jtag_dev);
 
 void adiv5_jtag_dp_handler(uint8_t jd_index);
@@ -397,6 +405,8 @@ const void *adiv5_pack_data(uint32_t dest, const void *src, uint32_t *data, alig
 void ap_mem_access_setup(adiv5_access_port_s *ap, uint32_t addr, align_e align);
 void adiv5_mem_write_bytes(adiv5_access_port_s *ap, uint32_t dest, const void *src, size_t len, align_e align);
 void advi5_mem_read_bytes(adiv5_access_port_s *ap, void *dest, uint32_t src, size_t len);
+void adiv5_mem_read_fifo(adiv5_access_port_s *ap, uint32_t *dest, uint32_t src, size_t count);
+void adiv5_mem_write_fifo(adiv5_access_port_s *ap, uint32_t dest, const uint32_t *src, size_t count);
 void firmware_ap_write(adiv5_access_port_s *ap, uint16_t addr, uint32_t value);
 uint32_t firmware_ap_read(adiv5_access_port_s *ap, uint16_t addr);
 uint32_t firmware_swdp_low_access(adiv5_debug_port_s *dp, uint8_t RnW, uint16_t addr, uint32_t value);
@@ -52,6 +52,8 @@ adiv5_access_port_s *cortex_ap(target_s *t)
 void cortex_priv_free(void *priv)
 {
 	adiv5_ap_unref(((cortex_priv_s *)priv)->ap);
+	if (((cortex_priv_s *)priv)->system_ap)
+		adiv5_ap_unref(((cortex_priv_s *)priv)->system_ap);
 	free(priv);
 }
 
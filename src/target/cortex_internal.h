@@ -54,6 +54,8 @@
 typedef struct cortex_priv {
 	/* AP from which this CPU hangs */
 	adiv5_access_port_s *ap;
+	/* System MEM-AP that can get at the same memory as the CPU, if one was found */
+	adiv5_access_port_s *system_ap;
 	/* Base address for the debug interface block */
 	uint32_t base_addr;
 	/* Cache parameters */
@@ -47,6 +47,7 @@
 #include "target.h"
 #include "target_internal.h"
 #include "target_probe.h"
+#include "command.h"
 #include "jep106.h"
 #include "cortex.h"
 #include "cortexar.h"
@@ -77,6 +78,8 @@ typedef struct cortexar_priv {
 
 	/* Control and status information */
 	uint8_t core_status;
+	/* Whether memory accesses should go via the system MEM-AP rather than the core */
+	bool system_ap_enabled;
 } cortexar_priv_s;
 
 #define CORTEXAR_DBG_IDR   0x000U /* ID register */
@@ -123,6 +126,9 @@ typedef struct cortexar_priv {
 #define CORTEXAR_DBG_DSCR_INTERRUPT_DISABLE  (1U << 11U)
 #define CORTEXAR_DBG_DSCR_ITR_ENABLE         (1U << 13U)
 #define CORTEXAR_DBG_DSCR_HALTING_DBG_ENABLE (1U << 14U)
+#define CORTEXAR_DBG_DSCR_DCC_MODE_MASK      (3U << 20U)
+#define CORTEXAR_DBG_DSCR_DCC_NON_BLOCKING   (0U << 20U)
+#define CORTEXAR_DBG_DSCR_DCC_FAST           (2U << 20U)
 #define CORTEXAR_DBG_DSCR_INSN_COMPLETE      (1U << 24U)
 #define CORTEXAR_DBG_DSCR_DTR_READ_READY     (1U << 29U)
 #define CORTEXAR_DBG_DSCR_DTR_WRITE_DONE     (1U << 30U)
@@ -331,6 +337,9 @@ static const uint16_t cortexar_spsr_encodings[5] = {
 #define CORTEXAR_STATUS_DATA_FAULT        (1U << 0U)
 #define CORTEXAR_STATUS_MMU_FAULT         (1U << 1U)
 #define CORTEXAR_STATUS_FAULT_CACHE_VALID (1U << 2U)
+#define CORTEXAR_STATUS_CACHES_CLEAN      (1U << 3U)
+
+#define CORTEXAR_MMU_PAGE_SIZE 4096U
 
 /*
  * Fields for Cortex-R special-purpose registers, used in the generation of GDB's target description XML.
@@ -363,6 +372,7 @@ static_assert(ARRAY_LENGTH(cortexr_spr_types) == ARRAY_LENGTH(cortexr_spr_names)
 /* clang-format on */
 
 static bool cortexar_check_error(target_s *target);
+static bool cortexa_cmd_system_ap(target_s *target, int argc, const char **argv);
 static void cortexar_mem_read(target_s *target, void *dest, target_addr_t src, size_t len);
 static void cortexar_mem_write(target_s *target, target_addr_t dest, const void *src, size_t len);
 
@@ -385,6 +395,11 @@ void cortexar_detach(target_s *target);
 
 static const char *cortexar_target_description(target_s *target);
 
+static const command_s cortexa_system_ap_cmd_list[] = {
+	{"system_ap", cortexa_cmd_system_ap, "Access memory through the system MEM-AP: [enable|disable]"},
+	{NULL, NULL, NULL},
+};
+
 static bool cortexar_run_insn(target_s *const target, const uint32_t insn)
 {
 	/* Issue the requested instruction to the core */
@@ -799,6 +814,8 @@ static target_s *cortexar_probe(
 	target->reg_read = cortexar_reg_read;
 	target->reg_write = cortexar_reg_write;
 	target->regs_size = sizeof(uint32_t) * CORTEXAR_GENERAL_REG_COUNT;
+	/* Registers are saved into core_regs on halt, so the target layer needn't cache them */
+	target->driver_caches_regs = true;
 
 	if (core_has_fpu) {
 		target->target_options |= TOPT_FLAVOUR_FLOAT;
@@ -837,6 +854,9 @@ bool cortexa_probe(adiv5_access_port_s *const ap, const target_addr_t base_addre
 	if (!target)
 		return false;
 
+	/* The system MEM-AP is only looked up when enabled, once the DP's AP scan is complete */
+	target_add_commands(target, cortexa_system_ap_cmd_list, target->driver);
+
 	switch (target->designer_code) {
 	case JEP106_MANUFACTURER_STM:
 		PROBE(stm32mp15_ca7_probe);
@@ -897,6 +917,9 @@ bool cortexar_attach(target_s *const target)
 	}
 
 	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	/* The core has been running since we last looked, so its data caches may be dirty */
+	priv->core_status &= ~CORTEXAR_STATUS_CACHES_CLEAN;
+
 	/* Clear any stale breakpoints */
 	priv->base.breakpoints_mask = 0U;
 	for (size_t i = 0; i <= priv->base.breakpoints_available; ++i) {
@@ -937,19 +960,55 @@ static bool cortexar_check_error(target_s *const target)
 {
 	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
 	const bool fault = priv->core_status & (CORTEXAR_STATUS_DATA_FAULT | CORTEXAR_STATUS_MMU_FAULT);
-	priv->core_status = (uint8_t) ~(CORTEXAR_STATUS_DATA_FAULT | CORTEXAR_STATUS_MMU_FAULT);
+	priv->core_status &= ~(CORTEXAR_STATUS_DATA_FAULT | CORTEXAR_STATUS_MMU_FAULT);
 	return fault || cortex_check_error(target);
 }
 
-/* Fast path for cortexar_mem_read(). Assumes the address to read data from is already loaded in r0. */
+/* Switch the DCC back to non-blocking mode, then wait for the last instruction fast mode issued to finish */
+static bool cortexar_dcc_fast_mode_exit(target_s *const target, const uint32_t dscr)
+{
+	cortex_dbg_write32(target, CORTEXAR_DBG_DSCR, dscr | CORTEXAR_DBG_DSCR_DCC_NON_BLOCKING);
+	uint32_t status = 0;
+	while (!(status & CORTEXAR_DBG_DSCR_INSN_COMPLETE))
+		status = cortex_dbg_read32(target, CORTEXAR_DBG_DSCR);
+	/* If any of the instructions triggered a synchronous data abort, the rest were dropped, so signal failure */
+	if (status & CORTEXAR_DBG_DSCR_SYNC_DATA_ABORT) {
+		cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+		priv->core_status |= CORTEXAR_STATUS_DATA_FAULT;
+		cortex_dbg_write32(target, CORTEXAR_DBG_DRCR, CORTEXAR_DBG_DRCR_CLR_STICKY_EXC);
+		return false;
+	}
+	return true;
+}
+
+/*
+ * Fast path for cortexar_mem_read(). Assumes the address to read data from is already loaded in r0.
+ * This uses the DCC's fast mode, in which the LDC sits latched in the ITR and reading DTRTX both returns
+ * the current word and reissues the LDC to fetch the next. That way each word is one AP access, rather
+ * than an instruction issue, status poll and data read.
+ */
 static inline bool cortexr_mem_read_fast(target_s *const target, uint32_t *const dest, const size_t count)
 {
-	/* Read each of the uint32_t's checking for failure */
-	for (size_t offset = 0; offset < count; ++offset) {
-		if (!cortexar_run_read_insn(target, ARM_LDC_R0_POSTINC4_DTRTX_INSN, dest + offset))
-			return false; /* Propagate failure if it happens */
+	if (!count)
+		return true;
+	const cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	const uint32_t dscr = cortex_dbg_read32(target, CORTEXAR_DBG_DSCR) & ~CORTEXAR_DBG_DSCR_DCC_MODE_MASK;
+	/*
+	 * Issue the first LDC normally so there's a word waiting in DTRTX, and make sure it completed without
+	 * faulting before switching to fast mode so we don't go on with an abort latched
+	 */
+	if (!cortexar_run_insn(target, ARM_LDC_R0_POSTINC4_DTRTX_INSN))
+		return false;
+	if (count > 1U) {
+		cortex_dbg_write32(target, CORTEXAR_DBG_DSCR, dscr | CORTEXAR_DBG_DSCR_DCC_FAST);
+		cortex_dbg_write32(target, CORTEXAR_DBG_ITR, ARM_LDC_R0_POSTINC4_DTRTX_INSN);
+		adiv5_mem_read_fifo(cortex_ap(target), dest, priv->base.base_addr + CORTEXAR_DBG_DTRRX, count - 1U);
 	}
-	return true; /* Signal success */
+	if (!cortexar_dcc_fast_mode_exit(target, dscr))
+		return false;
+	/* The last LDC issued leaves the final word in DTRTX */
+	dest[count - 1U] = cortex_dbg_read32(target, CORTEXAR_DBG_DTRRX);
+	return true;
 }
 
 /* Slow path for cortexar_mem_read(). Trashes r0 and r1. */
@@ -1007,6 +1066,74 @@ static void cortexr_mem_handle_fault(target_s *const target, const char *const f
 	}
 }
 
+/*
+ * Clean and invalidate the core's data caches so the system MEM-AP sees the same memory the core does.
+ * This only needs doing once per halt as the core can't dirty anything again until it's resumed.
+ */
+static void cortexa_system_ap_prepare(target_s *const target)
+{
+	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	if (!(priv->core_status & CORTEXAR_STATUS_CACHES_CLEAN)) {
+		cortexar_invalidate_all_caches(target);
+		priv->core_status |= CORTEXAR_STATUS_CACHES_CLEAN;
+	}
+	/* Clear any existing fault state */
+	priv->core_status &= ~(CORTEXAR_STATUS_DATA_FAULT | CORTEXAR_STATUS_MMU_FAULT);
+}
+
+/*
+ * Work out how much of an access starting at address fits in the current MMU page, and where that is in physical
+ * memory. Returns 0 if the translation faulted. NB: This requires the core to be halted! Trashes r0.
+ */
+static size_t cortexa_system_ap_translate(
+	target_s *const target, const target_addr_t address, const size_t len, target_addr_t *const phys_addr)
+{
+	const cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	*phys_addr = cortexar_virt_to_phys(target, address);
+	if (priv->core_status & CORTEXAR_STATUS_MMU_FAULT)
+		return 0U;
+	return MIN(len, CORTEXAR_MMU_PAGE_SIZE - (address & (CORTEXAR_MMU_PAGE_SIZE - 1U)));
+}
+
+/* This reads memory a page at a time via the system MEM-AP. NB: This requires the core to be halted! Trashes r0. */
+static void cortexa_system_ap_mem_read(target_s *const target, void *const dest, const target_addr_t src, size_t len)
+{
+	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	cortexa_system_ap_prepare(target);
+	uint8_t *data = (uint8_t *)dest;
+	target_addr_t address = src;
+	while (len) {
+		target_addr_t phys_addr = 0U;
+		const size_t amount = cortexa_system_ap_translate(target, address, len, &phys_addr);
+		if (!amount)
+			return;
+		adiv5_mem_read(priv->base.system_ap, data, phys_addr, amount);
+		data += amount;
+		address += amount;
+		len -= amount;
+	}
+}
+
+/* This writes memory a page at a time via the system MEM-AP. NB: This requires the core to be halted! Trashes r0. */
+static void cortexa_system_ap_mem_write(
+	target_s *const target, const target_addr_t dest, const void *const src, size_t len)
+{
+	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	cortexa_system_ap_prepare(target);
+	const uint8_t *data = (const uint8_t *)src;
+	target_addr_t address = dest;
+	while (len) {
+		target_addr_t phys_addr = 0U;
+		const size_t amount = cortexa_system_ap_translate(target, address, len, &phys_addr);
+		if (!amount)
+			return;
+		adiv5_mem_write(priv->base.system_ap, phys_addr, data, amount);
+		data += amount;
+		address += amount;
+		len -= amount;
+	}
+}
+
 /*
  * This reads memory by jumping from the debug unit bus to the system bus.
  * NB: This requires the core to be halted! Uses instruction launches on
@@ -1015,6 +1142,10 @@ static void cortexr_mem_handle_fault(target_s *const target, const char *const f
 static void cortexar_mem_read(target_s *const target, void *const dest, const target_addr_t src, const size_t len)
 {
 	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	if (priv->system_ap_enabled) {
+		cortexa_system_ap_mem_read(target, dest, src, len);
+		return;
+	}
 	/* Cache DFSR and DFAR in case we wind up triggering a data fault */
 	if (!(priv->core_status & CORTEXAR_STATUS_FAULT_CACHE_VALID)) {
 		priv->fault_status = cortexar_coproc_read(target, CORTEXAR_DFSR);
@@ -1049,15 +1180,20 @@ static void cortexar_mem_read(target_s *const target, void *const dest, const ta
 	DEBUG_PROTO("\n");
 }
 
-/* Fast path for cortexar_mem_write(). Assumes the address to read data from is already loaded in r0. */
+/*
+ * Fast path for cortexar_mem_write(). Assumes the address to write data to is already loaded in r0.
+ * As with reads this uses the DCC's fast mode, where each write to DTRRX reissues the STC latched in the ITR.
+ */
 static inline bool cortexr_mem_write_fast(target_s *const target, const uint32_t *const src, const size_t count)
 {
-	/* Read each of the uint32_t's checking for failure */
-	for (size_t offset = 0; offset < count; ++offset) {
-		if (!cortexar_run_write_insn(target, ARM_STC_DTRRX_R0_POSTINC4_INSN, src[offset]))
-			return false; /* Propagate failure if it happens */
-	}
-	return true; /* Signal success */
+	if (!count)
+		return true;
+	const cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	const uint32_t dscr = cortex_dbg_read32(target, CORTEXAR_DBG_DSCR) & ~CORTEXAR_DBG_DSCR_DCC_MODE_MASK;
+	cortex_dbg_write32(target, CORTEXAR_DBG_DSCR, dscr | CORTEXAR_DBG_DSCR_DCC_FAST);
+	cortex_dbg_write32(target, CORTEXAR_DBG_ITR, ARM_STC_DTRRX_R0_POSTINC4_INSN);
+	adiv5_mem_write_fifo(cortex_ap(target), priv->base.base_addr + CORTEXAR_DBG_DTRTX, src, count);
+	return cortexar_dcc_fast_mode_exit(target, dscr);
 }
 
 /* Slow path for cortexar_mem_write(). Trashes r0 and r1. */
@@ -1121,6 +1257,11 @@ static void cortexar_mem_write(
 		DEBUG_PROTO(" ...");
 	DEBUG_PROTO("\n");
 
+	if (priv->system_ap_enabled) {
+		cortexa_system_ap_mem_write(target, dest, src, len);
+		return;
+	}
+
 	/* Cache DFSR and DFAR in case we wind up triggering a data fault */
 	if (!(priv->core_status & CORTEXAR_STATUS_FAULT_CACHE_VALID)) {
 		priv->fault_status = cortexar_coproc_read(target, CORTEXAR_DFSR);
@@ -1230,6 +1371,9 @@ static ssize_t cortexar_reg_write(target_s *const target, const uint32_t reg, co
 
 static void cortexar_reset(target_s *const target)
 {
+	/* The core runs again out of reset, so its data caches may be dirty afterwards */
+	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	priv->core_status &= ~CORTEXAR_STATUS_CACHES_CLEAN;
 	/* Read PRSR here to clear DBG_PRSR.SR before reset */
 	cortex_dbg_read32(target, CORTEXAR_DBG_PRSR);
 	/* If the physical reset pin is not inhibited, use it */
@@ -1369,8 +1513,8 @@ static void cortexar_halt_resume(target_s *const target, const bool step)
 	/* Invalidate all the instruction caches if we're on a VMSA model device */
 	if (target->target_options & TOPT_FLAVOUR_VIRT_MEM)
 		cortexar_coproc_write(target, CORTEXAR_ICIALLU, 0U);
-	/* Mark the fault status and address cache invalid */
-	priv->core_status &= ~CORTEXAR_STATUS_FAULT_CACHE_VALID;
+	/* Mark the fault status and address cache invalid, and the data caches as potentially dirty again */
+	priv->core_status &= ~(CORTEXAR_STATUS_FAULT_CACHE_VALID | CORTEXAR_STATUS_CACHES_CLEAN);
 
 	cortex_dbg_write32(target, CORTEXAR_DBG_DSCR, dscr & ~CORTEXAR_DBG_DSCR_ITR_ENABLE);
 	/* Ask to resume the core */
@@ -1706,3 +1850,28 @@ static const char *cortexar_target_description(target_s *const target)
 			description, description_length, target->target_options & TOPT_FLAVOUR_FLOAT);
 	return description;
 }
+
+static bool cortexa_cmd_system_ap(target_s *const target, const int argc, const char **const argv)
+{
+	cortexar_priv_s *const priv = (cortexar_priv_s *)target->priv;
+	bool enable = priv->system_ap_enabled;
+	if (argc > 1 && !parse_enable_or_disable(argv[1], &enable))
+		return false;
+	/* Pick a MEM-AP from the ones the DP scan found the first time this is enabled */
+	if (enable && !priv->base.system_ap) {
+		priv->base.system_ap = adiv5_find_system_ap(cortex_ap(target)->dp);
+		if (!priv->base.system_ap) {
+			tc_printf(target, "No system MEM-AP found\n");
+			return false;
+		}
+	}
+	priv->system_ap_enabled = enable;
+	const adiv5_access_port_s *const system_ap = priv->base.system_ap;
+	if (!system_ap) {
+		tc_printf(target, "Memory access through a system MEM-AP: disabled\n");
+		return true;
+	}
+	tc_printf(target, "Memory access through AP %u (IDR 0x%08" PRIx32 "): %s\n", system_ap->apsel, system_ap->idr,
+		enable ? "enabled" : "disabled");
+	return true;
+}
@@ -43,6 +43,8 @@
 #include "semihosting.h"
 #include "platform.h"
 #include "maths_utils.h"
+#include "buffer_utils.h"
+#include "gdb_if.h"
 
 #include <assert.h>
 
@@ -59,6 +61,7 @@ const command_s cortexm_cmd_list[] = {
 static const char *cortexm_regs_description(target_s *target);
 static void cortexm_regs_read(target_s *target, void *data);
 static void cortexm_regs_write(target_s *target, const void *data);
+static bool cortexm_crc32(target_s *target, uint32_t *result, target_addr_t base, size_t len);
 static uint32_t cortexm_pc_read(target_s *target);
 static ssize_t cortexm_reg_read(target_s *target, uint32_t reg, void *data, size_t max);
 static ssize_t cortexm_reg_write(target_s *target, uint32_t reg, const void *data, size_t max);
@@ -82,6 +85,9 @@ typedef struct cortexm_priv {
 	uint32_t flash_patch_revision;
 	/* Copy of DEMCR for vector-catch */
 	uint32_t demcr;
+	/* Core registers as read during the current stop, valid until the core next runs */
+	bool regs_cached;
+	uint32_t reg_cache[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
 } cortexm_priv_s;
 
 /* Register number tables */
@@ -509,9 +515,12 @@ bool cortexm_probe(adiv5_access_port_s *ap)
 	target->halt_poll = cortexm_halt_poll;
 	target->halt_resume = cortexm_halt_resume;
 	target->regs_size = sizeof(uint32_t) * CORTEXM_GENERAL_REG_COUNT;
+	/* Registers are cached per stop in reg_cache, so the target layer needn't */
+	target->driver_caches_regs = true;
 
 	target->breakwatch_set = cortexm_breakwatch_set;
 	target->breakwatch_clear = cortexm_breakwatch_clear;
+	target->crc32 = cortexm_crc32;
 
 	target_add_commands(target, cortexm_cmd_list, target->driver);
 
@@ -695,6 +704,7 @@ bool cortexm_attach(target_s *target)
 
 	/* Clear any pending fault condition (and switch to this core) */
 	target_check_error(target);
+	priv->regs_cached = false;
 
 	target_halt_request(target);
 	/* Request halt on reset */
@@ -775,9 +785,37 @@ enum {
 	DB_DEMCR
 };
 
-static void cortexm_regs_read(target_s *const target, void *const data)
+/*
+ * Read a run of core registers through the AP's banked DCRSR/DCRDR window. The DCRDR reads are posted
+ * and chained so each result is collected by the next register's accesses rather than by a RDBUFF read
+ * per register: on SWD it comes back on the next AP read, on JTAG the DCRSR write scan captures it.
+ */
+static void cortexm_banked_regs_read(
+	adiv5_access_port_s *const ap, const uint32_t *const regnums, uint32_t *const regs, const size_t count)
+{
+	adiv5_debug_port_s *const dp = ap->dp;
+	/* If we don't know how this DP returns posted reads, do it the long way round */
+	if (dp->dp_read != firmware_swdp_read && dp->dp_read != fw_adiv5_jtagdp_read) {
+		for (size_t i = 0; i < count; ++i) {
+			adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_DB(DB_DCRSR), regnums[i]);
+			regs[i] = adiv5_dp_read(dp, ADIV5_AP_DB(DB_DCRDR));
+		}
+		return;
+	}
+
+	const bool jtag = dp->dp_read == fw_adiv5_jtagdp_read;
+	adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_DB(DB_DCRSR), regnums[0]);
+	adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_AP_DB(DB_DCRDR), 0);
+	for (size_t i = 1; i < count; ++i) {
+		const uint32_t captured = adiv5_dp_low_access(dp, ADIV5_LOW_WRITE, ADIV5_AP_DB(DB_DCRSR), regnums[i]);
+		const uint32_t value = adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_AP_DB(DB_DCRDR), 0);
+		regs[i - 1U] = jtag ? captured : value;
+	}
+	regs[count - 1U] = adiv5_dp_low_access(dp, ADIV5_LOW_READ, ADIV5_DP_RDBUFF, 0);
+}
+
+static void cortexm_regs_fetch(target_s *const target, uint32_t *const regs)
 {
-	uint32_t *const regs = data;
 	adiv5_access_port_s *const ap = cortex_ap(target);
 #if PC_HOSTED == 1
 	if (ap->dp->ap_regs_read && ap->dp->ap_reg_read) {
@@ -804,27 +842,33 @@ static void cortexm_regs_read(target_s *const target, void *const data)
 		adiv5_dp_write(ap->dp, ADIV5_DP_SELECT, ((uint32_t)ap->apsel << 24U) | 0x10U);
 
 		/* Walk the regnum_cortex_m array, reading the registers it specifies */
-		for (size_t i = 0; i < CORTEXM_GENERAL_REG_COUNT; ++i) {
-			adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_DB(DB_DCRSR), regnum_cortex_m[i]);
-			regs[i] = adiv5_dp_read(ap->dp, ADIV5_AP_DB(DB_DCRDR));
-		}
+		cortexm_banked_regs_read(ap, regnum_cortex_m, regs, CORTEXM_GENERAL_REG_COUNT);
 		/* If the device has a FPU, also walk the regnum_cortex_mf array */
-		if (target->target_options & CORTEXM_TOPT_FLAVOUR_V7MF) {
-			const size_t offset = CORTEXM_GENERAL_REG_COUNT;
-			for (size_t i = 0; i < CORTEX_FLOAT_REG_COUNT; ++i) {
-				adiv5_dp_low_access(ap->dp, ADIV5_LOW_WRITE, ADIV5_AP_DB(DB_DCRSR), regnum_cortex_mf[i]);
-				regs[offset + i] = adiv5_dp_read(ap->dp, ADIV5_AP_DB(DB_DCRDR));
-			}
-		}
+		if (target->target_options & CORTEXM_TOPT_FLAVOUR_V7MF)
+			cortexm_banked_regs_read(ap, regnum_cortex_mf, regs + CORTEXM_GENERAL_REG_COUNT, CORTEX_FLOAT_REG_COUNT);
 #if PC_HOSTED == 1
 	}
 #endif
 }
 
+static void cortexm_regs_read(target_s *const target, void *const data)
+{
+	cortexm_priv_s *const priv = target->priv;
+	/* The registers can't change until the core runs again, so only go to the core once per stop */
+	if (!priv->regs_cached) {
+		cortexm_regs_fetch(target, priv->reg_cache);
+		priv->regs_cached = !cortex_ap(target)->dp->fault;
+	}
+	memcpy(data, priv->reg_cache, target->regs_size);
+}
+
 static void cortexm_regs_write(target_s *const target, const void *const data)
 {
 	const uint32_t *const regs = data;
 	adiv5_access_port_s *const ap = cortex_ap(target);
+	cortexm_priv_s *const priv = target->priv;
+	/* Some register bits are read-only, so let the next read pick up what the core actually took */
+	priv->regs_cached = false;
 #if PC_HOSTED == 1
 	if (ap->dp->ap_reg_write) {
 		for (size_t i = 0; i < CORTEXM_GENERAL_REG_COUNT; ++i)
@@ -886,6 +930,11 @@ static ssize_t cortexm_reg_read(target_s *target, uint32_t reg, void *data, size
 	if (max < 4U)
 		return -1;
 	uint32_t *r = data;
+	const cortexm_priv_s *const priv = target->priv;
+	if (priv->regs_cached && reg < target->regs_size / 4U) {
+		*r = priv->reg_cache[reg];
+		return 4U;
+	}
 	target_mem_write32(target, CORTEXM_DCRSR, dcrsr_regnum(target, reg));
 	*r = target_mem_read32(target, CORTEXM_DCRDR);
 	return 4U;
@@ -896,6 +945,8 @@ static ssize_t cortexm_reg_write(target_s *target, uint32_t reg, const void *dat
 	if (max < 4U)
 		return -1;
 	const uint32_t *r = data;
+	cortexm_priv_s *const priv = target->priv;
+	priv->regs_cached = false;
 	target_mem_write32(target, CORTEXM_DCRDR, *r);
 	target_mem_write32(target, CORTEXM_DCRSR, CORTEXM_DCRSR_REGWnR | dcrsr_regnum(target, reg));
 	return 4U;
@@ -903,12 +954,17 @@ static ssize_t cortexm_reg_write(target_s *target, uint32_t reg, const void *dat
 
 static uint32_t cortexm_pc_read(target_s *target)
 {
+	const cortexm_priv_s *const priv = target->priv;
+	if (priv->regs_cached)
+		return priv->reg_cache[CORTEX_REG_PC];
 	target_mem_write32(target, CORTEXM_DCRSR, 0x0f);
 	return target_mem_read32(target, CORTEXM_DCRDR);
 }
 
 static void cortexm_pc_write(target_s *target, const uint32_t val)
 {
+	cortexm_priv_s *const priv = target->priv;
+	priv->regs_cached = false;
 	target_mem_write32(target, CORTEXM_DCRDR, val);
 	target_mem_write32(target, CORTEXM_DCRSR, CORTEXM_DCRSR_REGWnR | 0x0fU);
 }
@@ -919,6 +975,8 @@ static void cortexm_pc_write(target_s *target, const uint32_t val)
  */
 static void cortexm_reset(target_s *const target)
 {
+	cortexm_priv_s *const priv = target->priv;
+	priv->regs_cached = false;
 	/* Read DHCSR here to clear S_RESET_ST bit before reset */
 	target_mem_read32(target, CORTEXM_DHCSR);
 	/* If the physical reset pin is not inhibited, use it */
@@ -997,6 +1055,8 @@ static target_halt_reason_e cortexm_halt_poll(target_s *target, target_addr_t *w
 	/* Check that the core actually halted */
 	if (!(dhcsr & CORTEXM_DHCSR_S_HALT))
 		return TARGET_HALT_RUNNING;
+	/* Anything read from the registers while the core was running is stale now */
+	priv->regs_cached = false;
 
 	/* Read out the status register to determine why */
 	uint32_t dfsr = target_mem_read32(target, CORTEXM_DFSR);
@@ -1066,6 +1126,7 @@ void cortexm_halt_resume(target_s *const target, const bool step)
 		target_mem_write32(target, CORTEXM_ICIALLU, 0);
 
 	/* Release C_HALT to resume the core in whichever mode is selected */
+	priv->regs_cached = false;
 	target_mem_write32(target, CORTEXM_DHCSR, dhcsr);
 }
 
@@ -1131,18 +1192,9 @@ static int cortexm_fault_unwind(target_s *target)
 	return 0;
 }
 
-bool cortexm_run_stub(target_s *target, uint32_t loadaddr, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3)
+/* Load the given register file and run the stub it points at until it hits a breakpoint */
+static bool cortexm_run_stub_regs(target_s *const target, const uint32_t *const regs)
 {
-	uint32_t regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT] = {0};
-
-	regs[0] = r0;
-	regs[1] = r1;
-	regs[2] = r2;
-	regs[3] = r3;
-	regs[15] = loadaddr;
-	regs[CORTEX_REG_XPSR] = CORTEXM_XPSR_THUMB;
-	regs[19] = 0;
-
 	cortexm_regs_write(target, regs);
 
 	if (target_check_error(target))
@@ -1154,6 +1206,10 @@ bool cortexm_run_stub(target_s *target, uint32_t loadaddr, uint32_t r0, uint32_t
 	uint32_t arm_regs_start[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
 	target_regs_read(target, arm_regs_start);
 #endif
+	/* Make sure breakwatches GDB has removed can't halt the stub */
+	(void)target_breakwatch_commit(target);
+	/* The stub can change memory without going through the target layer, so drop anything cached */
+	target_read_cache_flush(target);
 	cortexm_halt_resume(target, 0);
 	platform_timeout_s timeout;
 	platform_timeout_set(&timeout, 5000);
@@ -1188,6 +1244,21 @@ bool cortexm_run_stub(target_s *target, uint32_t loadaddr, uint32_t r0, uint32_t
 	return bkpt_instr & 0xffU;
 }
 
+bool cortexm_run_stub(target_s *target, uint32_t loadaddr, uint32_t r0, uint32_t r1, uint32_t r2, uint32_t r3)
+{
+	uint32_t regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT] = {0};
+
+	regs[0] = r0;
+	regs[1] = r1;
+	regs[2] = r2;
+	regs[3] = r3;
+	regs[15] = loadaddr;
+	regs[CORTEX_REG_XPSR] = CORTEXM_XPSR_THUMB;
+	regs[19] = 0;
+
+	return cortexm_run_stub_regs(target, regs);
+}
+
 /*
  * The following routines implement hardware breakpoints and watchpoints.
  * The Flash Patch and Breakpoint (FPB) and Data Watch and Trace (DWT)
@@ -1225,6 +1296,38 @@ static uint32_t cortexm_dwt_func(target_s *target, target_breakwatch_e type)
 	}
 }
 
+/* Thumb BKPT #0, patched over the instruction at a software breakpoint */
+#define CORTEXM_THUMB_BKPT 0xbe00U
+/* Marks a software breakpoint as patched into RAM, rather than using an FPB comparator */
+#define CORTEXM_BREAK_PATCHED 1U
+
+static bool cortexm_addr_in_ram(target_s *const target, const target_addr_t addr, const size_t len)
+{
+	for (const target_ram_s *ram = target->ram; ram; ram = ram->next) {
+		if (addr >= ram->start && addr - ram->start + len <= ram->length)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Set a software breakpoint by patching a BKPT over the instruction at the breakpoint address, keeping the
+ * original instruction to put back on clear. 32-bit Thumb-2 instructions (kind 3) only need their first
+ * half-word replacing. Returns false if the patch didn't take, such as if the "RAM" is read-only.
+ */
+static bool cortexm_soft_breakpoint_set(target_s *const target, breakwatch_s *const breakwatch)
+{
+	const uint16_t instruction = target_mem_read16(target, breakwatch->addr);
+	target_mem_write16(target, breakwatch->addr, CORTEXM_THUMB_BKPT);
+	if (target_check_error(target) || target_mem_read16(target, breakwatch->addr) != CORTEXM_THUMB_BKPT) {
+		target_mem_write16(target, breakwatch->addr, instruction);
+		return false;
+	}
+	breakwatch->reserved[0] = instruction;
+	breakwatch->reserved[1] = CORTEXM_BREAK_PATCHED;
+	return true;
+}
+
 static int cortexm_breakwatch_set(target_s *target, breakwatch_s *breakwatch)
 {
 	cortexm_priv_s *priv = target->priv;
@@ -1232,6 +1335,13 @@ static int cortexm_breakwatch_set(target_s *target, breakwatch_s *breakwatch)
 	uint32_t val = breakwatch->addr;
 
 	switch (breakwatch->type) {
+	case TARGET_BREAK_SOFT:
+		/* Software breakpoints in RAM get patched in, saving the FPB comparators for the code in Flash */
+		if ((breakwatch->size == 2U || breakwatch->size == 3U) && !(breakwatch->addr & 1U) &&
+			cortexm_addr_in_ram(target, breakwatch->addr, 2U) && cortexm_soft_breakpoint_set(target, breakwatch))
+			return 0;
+		/* Anywhere else, fall back to using a comparator */
+		/* fall through */
 	case TARGET_BREAK_HARD:
 		if (priv->flash_patch_revision == 0) {
 			val &= 0x1ffffffcU;
@@ -1251,6 +1361,7 @@ static int cortexm_breakwatch_set(target_s *target, breakwatch_s *breakwatch)
 		priv->base.breakpoints_mask |= 1U << i;
 		target_mem_write32(target, CORTEXM_FPB_COMP(i), val);
 		breakwatch->reserved[0] = i;
+		breakwatch->reserved[1] = 0U;
 		return 0;
 
 	case TARGET_WATCH_WRITE:
@@ -1283,6 +1394,13 @@ static int cortexm_breakwatch_clear(target_s *target, breakwatch_s *breakwatch)
 	cortexm_priv_s *priv = target->priv;
 	unsigned i = breakwatch->reserved[0];
 	switch (breakwatch->type) {
+	case TARGET_BREAK_SOFT:
+		/* Put back the instruction the breakpoint was patched over */
+		if (breakwatch->reserved[1] == CORTEXM_BREAK_PATCHED) {
+			target_mem_write16(target, breakwatch->addr, breakwatch->reserved[0]);
+			return 0;
+		}
+		/* fall through */
 	case TARGET_BREAK_HARD:
 		priv->base.breakpoints_mask &= ~(1U << i);
 		target_mem_write32(target, CORTEXM_FPB_COMP(i), 0);
@@ -1370,3 +1488,123 @@ static bool cortexm_hostio_request(target_s *const target)
 	/* Return if the request was in any way interrupted */
 	return target->tc->interrupted;
 }
+
+/*
+ * The CRC stub is loaded at the start of a RAM region with its lookup table following it and a small stack
+ * above that. The stub halts on the BKPT at CORTEXM_CRC32_STUB_EXIT, and each run is limited so it stays
+ * well inside the cortexm_run_stub() timeout even on a slow-clocked part.
+ */
+#define CORTEXM_CRC32_STUB_EXIT         0x18U
+#define CORTEXM_CRC32_STUB_TABLE_OFFSET 0x20U
+#define CORTEXM_CRC32_STUB_SIZE         (CORTEXM_CRC32_STUB_TABLE_OFFSET + (256U * 4U))
+#define CORTEXM_CRC32_STUB_STACK_SIZE   0x80U
+#define CORTEXM_CRC32_STUB_RAM_SIZE     (CORTEXM_CRC32_STUB_SIZE + CORTEXM_CRC32_STUB_STACK_SIZE)
+#define CORTEXM_CRC32_STUB_CHUNK        0x40000U
+
+static const uint16_t cortexm_crc32_stub[] = {
+#include "flashstub/crc32.stub"
+};
+
+/*
+ * Run the loaded CRC stub over the region a chunk at a time. The stub runs with PRIMASK set so the
+ * application's interrupt handlers can't run underneath it, and with its own stack in case of a fault.
+ */
+static bool cortexm_crc32_run(target_s *const target, const target_addr_t stub_addr, const target_addr_t base,
+	const size_t len, uint32_t *const result)
+{
+	uint32_t crc = 0xffffffffU;
+	uint32_t last_time = platform_time_ms();
+	for (size_t offset = 0; offset < len; offset += CORTEXM_CRC32_STUB_CHUNK) {
+		const uint32_t actual_time = platform_time_ms();
+		if (actual_time > last_time + 1000U) {
+			last_time = actual_time;
+			gdb_if_putchar(0, true);
+		}
+		uint32_t regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT] = {0};
+		regs[0] = base + offset;
+		regs[1] = MIN(len - offset, CORTEXM_CRC32_STUB_CHUNK);
+		regs[2] = crc;
+		regs[3] = stub_addr + CORTEXM_CRC32_STUB_TABLE_OFFSET;
+		regs[CORTEX_REG_SP] = stub_addr + CORTEXM_CRC32_STUB_RAM_SIZE;
+		regs[CORTEX_REG_PC] = stub_addr;
+		regs[CORTEX_REG_XPSR] = CORTEXM_XPSR_THUMB;
+		regs[CORTEX_REG_MSP] = regs[CORTEX_REG_SP];
+		/* PRIMASK is the bottom byte of the CONTROL/FAULTMASK/BASEPRI/PRIMASK special register */
+		regs[CORTEX_REG_SPECIAL] = 1U;
+		cortexm_run_stub_regs(target, regs);
+		/* The stub only counts as having finished if it stopped on its own breakpoint with nothing left to do */
+		target_regs_read(target, regs);
+		if (regs[CORTEX_REG_PC] != stub_addr + CORTEXM_CRC32_STUB_EXIT || regs[1] != 0U)
+			return false;
+		crc = regs[2];
+	}
+	*result = crc;
+	return true;
+}
+
+/* Find some RAM big enough for the stub that doesn't overlap the region being checked */
+static bool cortexm_crc32_find_ram(
+	target_s *const target, const target_addr_t base, const size_t len, target_addr_t *const stub_addr)
+{
+	for (const target_ram_s *ram = target->ram; ram; ram = ram->next) {
+		if (ram->length >= CORTEXM_CRC32_STUB_RAM_SIZE &&
+			(base >= ram->start + CORTEXM_CRC32_STUB_RAM_SIZE || base + len <= ram->start)) {
+			*stub_addr = ram->start;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Compute the qCRC checksum of a region by running a table driven CRC routine on the core itself,
+ * so only the stub, its table and the result have to cross the link. The registers and the RAM
+ * the stub borrows are put back afterwards, even if the stub gets the target lost.
+ */
+static bool cortexm_crc32(target_s *const target, uint32_t *const result, const target_addr_t base, const size_t len)
+{
+	target_addr_t stub_addr = 0U;
+	if (!cortexm_crc32_find_ram(target, base, len, &stub_addr))
+		return false;
+
+	uint8_t *const stub = malloc(CORTEXM_CRC32_STUB_SIZE + CORTEXM_CRC32_STUB_RAM_SIZE);
+	if (!stub) { /* malloc failed: heap exhaustion */
+		DEBUG_ERROR("malloc: failed in %s\n", __func__);
+		return false;
+	}
+	uint8_t *const saved_ram = stub + CORTEXM_CRC32_STUB_SIZE;
+
+	/* Build the stub image and the lookup table for polynomial 0x04c11db7 */
+	memset(stub, 0, CORTEXM_CRC32_STUB_TABLE_OFFSET);
+	memcpy(stub, cortexm_crc32_stub, sizeof(cortexm_crc32_stub));
+	for (uint32_t i = 0; i < 256U; ++i) {
+		uint32_t value = i << 24U;
+		for (size_t bit = 0; bit < 8U; ++bit)
+			value = (value & 0x80000000U) ? (value << 1U) ^ 0x04c11db7U : value << 1U;
+		write_le4(stub, CORTEXM_CRC32_STUB_TABLE_OFFSET + (i * 4U), value);
+	}
+
+	/* Save off everything the stub will clobber, then load it */
+	uint32_t saved_regs[CORTEXM_GENERAL_REG_COUNT + CORTEX_FLOAT_REG_COUNT];
+	target_regs_read(target, saved_regs);
+	bool success = !target_mem_read(target, saved_ram, stub_addr, CORTEXM_CRC32_STUB_RAM_SIZE) &&
+		!target_mem_write(target, stub_addr, stub, CORTEXM_CRC32_STUB_SIZE);
+
+	uint32_t crc = 0U;
+	volatile exception_s e;
+	TRY_CATCH (e, EXCEPTION_ALL) {
+		if (success)
+			success = cortexm_crc32_run(target, stub_addr, base, len, &crc);
+	}
+
+	/* Put the RAM and registers back how we found them */
+	target_mem_write(target, stub_addr, saved_ram, CORTEXM_CRC32_STUB_RAM_SIZE);
+	target_regs_write(target, saved_regs);
+	free(stub);
+	if (e.type)
+		raise_exception(e.type, e.msg);
+
+	if (success)
+		*result = crc;
+	return success;
+}
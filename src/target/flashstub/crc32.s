@@ -0,0 +1,40 @@
+@ This file is part of the Black Magic Debug project.
+@
+@ Copyright (C) 2026 1BitSquared <info@1bitsquared.com>
+@
+@ This program is free software: you can redistribute it and/or modify
+@ it under the terms of the GNU General Public License as published by
+@ the Free Software Foundation, either version 3 of the License, or
+@ (at your option) any later version.
+@
+@ This program is distributed in the hope that it will be useful,
+@ but WITHOUT ANY WARRANTY; without even the implied warranty of
+@ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+@ GNU General Public License for more details.
+@
+@ You should have received a copy of the GNU General Public License
+@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+@ Table driven CRC32 (polynomial 0x04c11db7, MSB first, as used by GDB's qCRC)
+@ r0: data, r1: length in bytes, r2: CRC in (and out), r3: 256 entry lookup table
+	.syntax unified
+	.thumb
+	.text
+	.global crc32_stub
+	.type crc32_stub, %function
+crc32_stub:
+loop:
+	cmp r1, #0
+	beq done
+	ldrb r5, [r0]
+	adds r0, #1
+	lsrs r6, r2, #24
+	eors r6, r5
+	lsls r6, r6, #2
+	ldr r6, [r3, r6]
+	lsls r2, r2, #8
+	eors r2, r6
+	subs r1, #1
+	b loop
+done:
+	bkpt #0
@@ -129,6 +129,7 @@
 #define IMXRT_FLEXSPI1_PRG_WRITE_FIFO(priv)        ((priv)->flexspi_base + 0x180U)
 #define IMXRT_FLEXSPI1_LUT_BASE(priv)              ((priv)->flexspi_base + 0x200U)
 
+#define IMXRT_FLEXSPI1_MOD_CTRL0_SWRESET          0x00000001U
 #define IMXRT_FLEXSPI1_MOD_CTRL0_SUSPEND          0x00000002U
 #define IMXRT_FLEXSPI1_INT_PRG_CMD_DONE           0x00000001U
 #define IMXRT_FLEXSPI1_INT_CMD_ERR                0x00000008U
@@ -191,6 +192,7 @@ typedef struct imxrt_priv {
 static imxrt_boot_src_e imxrt_boot_source(uint32_t boot_cfg);
 static bool imxrt_enter_flash_mode(target_s *target);
 static bool imxrt_exit_flash_mode(target_s *target);
+static bool imxrt_flash_map(target_flash_s *flash, bool mapped);
 static uint8_t imxrt_spi_build_insn_sequence(target_s *target, uint16_t command, uint16_t length);
 static void imxrt_spi_read(target_s *target, uint16_t command, target_addr_t address, void *buffer, size_t length);
 static void imxrt_spi_write(
@@ -262,8 +264,11 @@ bool imxrt_probe(target_s *const target)
 			const uint32_t capacity = 1U << flash_id.capacity;
 			DEBUG_INFO("SPI Flash: mfr = %02x, type = %02x, capacity = %08" PRIx32 "\n", flash_id.manufacturer,
 				flash_id.type, capacity);
-			bmp_spi_add_flash(
+			spi_flash_s *const spi_flash = bmp_spi_add_flash(
 				target, IMXRT_FLEXSPI_BASE, capacity, imxrt_spi_read, imxrt_spi_write, imxrt_spi_run_command);
+			/* Let reads during a Flash session go through the AHB window */
+			if (spi_flash)
+				spi_flash->flash.map = imxrt_flash_map;
 		} else
 			DEBUG_INFO("Flash identification failed\n");
 
@@ -422,12 +427,48 @@ static bool imxrt_enter_flash_mode(target_s *const target)
 	return true;
 }
 
+static void imxrt_flexspi_flush_ahb(target_s *const target)
+{
+	const imxrt_priv_s *const priv = (imxrt_priv_s *)target->target_storage;
+	/* A software reset of the controller invalidates the AHB read buffers but leaves the configuration intact */
+	target_mem_write32(target, IMXRT_FLEXSPI1_MOD_CTRL0(priv),
+		target_mem_read32(target, IMXRT_FLEXSPI1_MOD_CTRL0(priv)) | IMXRT_FLEXSPI1_MOD_CTRL0_SWRESET);
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, 10U);
+	while (target_mem_read32(target, IMXRT_FLEXSPI1_MOD_CTRL0(priv)) & IMXRT_FLEXSPI1_MOD_CTRL0_SWRESET) {
+		if (platform_timeout_is_expired(&timeout)) {
+			DEBUG_WARN("FlexSPI software reset timed out\n");
+			break;
+		}
+	}
+}
+
+static bool imxrt_flash_map(target_flash_s *const flash, const bool mapped)
+{
+	target_s *const target = flash->t;
+	imxrt_priv_s *const priv = (imxrt_priv_s *)target->target_storage;
+	/*
+	 * Our command sequences may have displaced the one AHB reads use, so put the LUT back and drop the
+	 * sequence cache so the next command rebuilds its slot. Then flush the AHB buffers so reads see the
+	 * newly programmed data. Switching back to command mode needs nothing further.
+	 */
+	if (mapped) {
+		target_mem_write(
+			target, IMXRT_FLEXSPI1_LUT_BASE(priv), priv->flexspi_prg_seq_state, sizeof(priv->flexspi_prg_seq_state));
+		memset(priv->flexspi_cached_commands, 0, sizeof(priv->flexspi_cached_commands));
+		imxrt_flexspi_flush_ahb(target);
+	}
+	return true;
+}
+
 static bool imxrt_exit_flash_mode(target_s *const target)
 {
 	const imxrt_priv_s *const priv = (imxrt_priv_s *)target->target_storage;
 	/* To leave Flash mode, we do things in the opposite order to entering. */
 	target_mem_write(
 		target, IMXRT_FLEXSPI1_LUT_BASE(priv), priv->flexspi_prg_seq_state, sizeof(priv->flexspi_prg_seq_state));
+	/* Make sure nothing stale from before programming is left in the AHB buffers */
+	imxrt_flexspi_flush_ahb(target);
 	if (priv->flexspi_lut_state != IMXRT_FLEXSPI1_LUT_CTRL_UNLOCK) {
 		target_mem_write32(target, IMXRT_FLEXSPI1_LUT_KEY(priv), IMXRT_FLEXSPI1_LUT_KEY_VALUE);
 		target_mem_write32(target, IMXRT_FLEXSPI1_LUT_CTRL(priv), priv->flexspi_lut_state);
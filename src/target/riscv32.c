@@ -68,6 +68,26 @@ typedef struct riscv32_regs {
 #define RV32_MATCH_BEFORE 0x00000000U
 #define RV32_MATCH_AFTER  0x00040000U
 
+/*
+ * Number of values to read at a time from a data register which starts the next access when read,
+ * as with abstract command autoexec and system bus read on data
+ */
+#define RV32_PIPELINED_READ_CHUNK 32U
+
+/* The program buffer memory access loops use s0 for the address and s1 for the data */
+#define RV32_GPR_S0 (RV_GPR_BASE + 8U)
+#define RV32_GPR_S1 (RV_GPR_BASE + 9U)
+/* sb/sh/sw s1, 0(s0) */
+#define RV32_INSN_STORE(access_width) (0x00940023U | ((uint32_t)(access_width) << 12U))
+/* addi s0, s0, imm */
+#define RV32_INSN_ADDI_S0(imm) (0x00040413U | ((uint32_t)(imm) << 20U))
+
+/* Abstract commands to move the program buffer loop registers to and from data0, optionally then running the loop */
+#define RV32_ABST_ACCESS_REG (RV_DM_ABST_CMD_ACCESS_REG | RV_REG_XFER | RV_REG_ACCESS_32_BIT)
+#define RV32_ABST_WRITE_S0   (RV32_ABST_ACCESS_REG | RV_ABST_WRITE | RV32_GPR_S0)
+#define RV32_ABST_WRITE_S1   (RV32_ABST_ACCESS_REG | RV_ABST_WRITE | RV32_GPR_S1)
+#define RV32_ABST_READ_S1    (RV32_ABST_ACCESS_REG | RV_ABST_READ | RV32_GPR_S1)
+
 static ssize_t riscv32_reg_read(target_s *target, uint32_t c, void *data, size_t max);
 static ssize_t riscv32_reg_write(target_s *target, uint32_t c, const void *data, size_t max);
 static void riscv32_regs_read(target_s *target, void *data);
@@ -106,14 +126,47 @@ bool riscv32_probe(target_s *const target)
 	return false;
 }
 
+/*
+ * Read GPRs x1 onwards with a single abstract command. The command post-increments the register number, and
+ * autoexec re-runs it on each read of data0, letting the DMI pipeline the reads. Returns false if this failed
+ * for any reason, in which case the registers have to be read one command at a time.
+ */
+static bool riscv32_regs_read_batched(riscv_hart_s *const hart, uint32_t *const gprs, const size_t gprs_count)
+{
+	const size_t last = gprs_count - 1U;
+	/* Read x1 into data0, moving on to x2 for the next time the command runs */
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, RV_ABST_AUTO_DATA0) ||
+		!riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND,
+			RV32_ABST_ACCESS_REG | RV_ABST_READ | RV_REG_POSTINC | (RV_GPR_BASE + 1U)))
+		return false;
+	/* Each read of data0 now returns one register and fetches the next */
+	const bool result = riscv_dm_read_block(hart->dbg_module, RV_DM_DATA0, gprs + 1U, last - 1U);
+	/* Wait for the final register to be fetched, and turn autoexec back off so reading it doesn't run the command */
+	const bool complete = riscv_command_wait_complete(hart);
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, 0U) || !result || !complete)
+		return false;
+	gprs[0] = 0U;
+	return riscv_dm_read(hart->dbg_module, RV_DM_DATA0, gprs + last);
+}
+
 static void riscv32_regs_read(target_s *const target, void *const data)
 {
 	/* Grab the hart structure and figure out how many registers need reading out */
 	riscv_hart_s *const hart = riscv_hart_struct(target);
 	riscv32_regs_s *const regs = (riscv32_regs_s *)data;
 	const size_t gprs_count = hart->extensions & RV_ISA_EXT_EMBEDDED ? 16U : 32U;
-	/* Loop through reading out the GPRs */
-	for (size_t gpr = 0; gpr < gprs_count; ++gpr) {
+	/* Try reading the GPRs in one batch */
+	bool batched = false;
+	if ((hart->flags & RV_HART_FLAG_ABSTRACT_AUTO) && !(hart->flags & RV_HART_FLAG_NO_REG_POSTINC)) {
+		batched = riscv32_regs_read_batched(hart, regs->gprs, gprs_count);
+		/* However the batch failed, retrying it on every read would only double the DMI traffic, so stop using it */
+		if (!batched) {
+			DEBUG_WARN("Batched register read failed, disabling it\n");
+			hart->flags |= RV_HART_FLAG_NO_REG_POSTINC;
+		}
+	}
+	/* Otherwise loop through reading out the GPRs */
+	for (size_t gpr = 0; !batched && gpr < gprs_count; ++gpr) {
 		// TODO: handle when this fails..
 		riscv_csr_read(hart, RV_GPR_BASE + gpr, &regs->gprs[gpr]);
 	}
@@ -214,6 +267,71 @@ uint32_t riscv32_pack_data(const void *const src, const uint8_t access_width)
 	return 0;
 }
 
+/*
+ * Read a block using abstractauto so each read of data0 returns the last transfer's result and starts the
+ * next one, making it a single DMI access per transfer. cmderr is only checked once at the end of the block.
+ * Returns false if the DM reported it was still busy at some point, meaning the block must be redone.
+ */
+static bool riscv32_abstract_mem_read_auto(riscv_hart_s *const hart, uint8_t *const data, const uint32_t command,
+	const uint8_t access_width, const size_t len)
+{
+	const uint8_t access_length = 1U << access_width;
+	const size_t last = len - access_length;
+	/* Turn on autoexec for data0 and run the first transfer */
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, RV_ABST_AUTO_DATA0) ||
+		!riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND, command))
+		return true;
+	bool result = true;
+	/* Read data0 in chunks so the DMI can pipeline the reads */
+	uint32_t values[RV32_PIPELINED_READ_CHUNK];
+	for (size_t offset = 0; result && offset < last;) {
+		const size_t count = MIN((last - offset) >> access_width, RV32_PIPELINED_READ_CHUNK);
+		result = riscv_dm_read_block(hart->dbg_module, RV_DM_DATA0, values, count);
+		for (size_t index = 0; result && index < count; ++index, offset += access_length)
+			riscv32_unpack_data(data + offset, values[index], access_width);
+	}
+	/* Wait for the final transfer, check how the block went, and turn autoexec back off */
+	const bool complete = riscv_command_wait_complete(hart);
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, 0U) || !result)
+		return true;
+	/* With autoexec off, the final read of data0 doesn't start another transfer */
+	uint32_t value = 0;
+	if (complete && riscv_dm_read(hart->dbg_module, RV_DM_DATA0, &value))
+		riscv32_unpack_data(data + last, value, access_width);
+	return complete || hart->status != RISCV_HART_BUSY;
+}
+
+/* As above, but for writes, where each write of data0 starts the transfer of the value written */
+static bool riscv32_abstract_mem_write_auto(riscv_hart_s *const hart, const uint8_t *const data,
+	const uint32_t command, const uint8_t access_width, const size_t len)
+{
+	const uint8_t access_length = 1U << access_width;
+	/* Load the first value and run its transfer, turning autoexec for data0 on for the rest */
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA0, riscv32_pack_data(data, access_width)) ||
+		!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, RV_ABST_AUTO_DATA0) ||
+		!riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND, command))
+		return true;
+	bool result = true;
+	for (size_t offset = access_length; offset < len; offset += access_length) {
+		if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA0, riscv32_pack_data(data + offset, access_width))) {
+			result = false;
+			break;
+		}
+	}
+	/* Wait for the final transfer, check how the block went, and turn autoexec back off */
+	const bool complete = riscv_command_wait_complete(hart);
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, 0U) || !result)
+		return true;
+	return complete || hart->status != RISCV_HART_BUSY;
+}
+
+/* Called when an autoexec block transfer found the DM too slow to keep up, so we stop using it on this hart */
+static void riscv32_abstract_auto_disable(riscv_hart_s *const hart)
+{
+	DEBUG_WARN("Abstract command autoexec overran the Debug Module, disabling it\n");
+	hart->flags &= (uint16_t)~RV_HART_FLAG_ABSTRACT_AUTO;
+}
+
 static void riscv32_abstract_mem_read(
 	riscv_hart_s *const hart, void *const dest, const target_addr_t src, const size_t len)
 {
@@ -227,6 +345,15 @@ static void riscv32_abstract_mem_read(
 	if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA1, src))
 		return;
 	uint8_t *const data = (uint8_t *)dest;
+	/* If there's more than one transfer to do and the DM supports it, use autoexec */
+	if ((hart->flags & RV_HART_FLAG_ABSTRACT_AUTO) && access_length < len) {
+		if (riscv32_abstract_mem_read_auto(hart, data, command, access_width, len))
+			return;
+		/* The DM couldn't keep up, so redo the block one command at a time */
+		riscv32_abstract_auto_disable(hart);
+		if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA1, src))
+			return;
+	}
 	for (size_t offset = 0; offset < len; offset += access_length) {
 		/* Execute the read */
 		if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND, command) || !riscv_command_wait_complete(hart))
@@ -252,6 +379,15 @@ static void riscv32_abstract_mem_write(
 	if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA1, dest))
 		return;
 	const uint8_t *const data = (const uint8_t *)src;
+	/* If there's more than one transfer to do and the DM supports it, use autoexec */
+	if ((hart->flags & RV_HART_FLAG_ABSTRACT_AUTO) && access_length < len) {
+		if (riscv32_abstract_mem_write_auto(hart, data, command, access_width, len))
+			return;
+		/* The DM couldn't keep up, so redo the block one command at a time */
+		riscv32_abstract_auto_disable(hart);
+		if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA1, dest))
+			return;
+	}
 	for (size_t offset = 0; offset < len; offset += access_length) {
 		/* Pack the data to write into arg0 */
 		uint32_t value = riscv32_pack_data(data + offset, access_width);
@@ -263,6 +399,162 @@ static void riscv32_abstract_mem_write(
 	}
 }
 
+static bool riscv32_abstract_command(riscv_hart_s *const hart, const uint32_t command)
+{
+	return riscv_dm_write(hart->dbg_module, RV_DM_ABST_COMMAND, command) && riscv_command_wait_complete(hart);
+}
+
+/* Check if the program buffer is big enough for the memory access loops, which are 2 instructions long */
+static bool riscv32_progbuf_usable(const riscv_hart_s *const hart)
+{
+	return riscv_progbuf_fits(hart, 2U);
+}
+
+/*
+ * Read count values using the program buffer loop, which loads the value at s0 into s1 and advances s0.
+ * Reading s1 out to data0 with postexec set hands back one value while fetching the next, and with autoexec
+ * this repeats on each read of data0 so the reads are pipelined. The loop is stopped one value short so
+ * it never reads past the end of the block.
+ */
+static bool riscv32_progbuf_mem_read_block(riscv_hart_s *const hart, uint8_t *const data, const target_addr_t src,
+	const size_t count, const uint8_t access_width)
+{
+	const uint8_t access_length = 1U << access_width;
+	/* Load the address into s0 and run the loop to fetch the first value into s1 */
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA0, src) ||
+		!riscv32_abstract_command(hart, RV32_ABST_WRITE_S0 | RV_REG_POSTEXEC))
+		return false;
+	size_t offset = 0;
+	if (count > 1U) {
+		/* Move the first value to data0 while fetching the second */
+		if (!riscv32_abstract_command(hart, RV32_ABST_READ_S1 | RV_REG_POSTEXEC))
+			return false;
+		const size_t last = (count - 2U) << access_width;
+		if (hart->flags & RV_HART_FLAG_ABSTRACT_AUTO) {
+			if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, RV_ABST_AUTO_DATA0))
+				return false;
+			bool result = true;
+			uint32_t values[RV32_PIPELINED_READ_CHUNK];
+			while (result && offset < last) {
+				const size_t chunk = MIN((last - offset) >> access_width, RV32_PIPELINED_READ_CHUNK);
+				result = riscv_dm_read_block(hart->dbg_module, RV_DM_DATA0, values, chunk);
+				for (size_t index = 0; result && index < chunk; ++index, offset += access_length)
+					riscv32_unpack_data(data + offset, values[index], access_width);
+			}
+			const bool complete = riscv_command_wait_complete(hart);
+			if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, 0U) || !result || !complete)
+				return false;
+		} else {
+			for (; offset < last; offset += access_length) {
+				uint32_t value = 0;
+				if (!riscv_dm_read(hart->dbg_module, RV_DM_DATA0, &value) ||
+					!riscv32_abstract_command(hart, RV32_ABST_READ_S1 | RV_REG_POSTEXEC))
+					return false;
+				riscv32_unpack_data(data + offset, value, access_width);
+			}
+		}
+		/* data0 now holds the second to last value */
+		uint32_t value = 0;
+		if (!riscv_dm_read(hart->dbg_module, RV_DM_DATA0, &value))
+			return false;
+		riscv32_unpack_data(data + offset, value, access_width);
+		offset += access_length;
+	}
+	/* Finally, move the last value out of s1 without running the loop again */
+	uint32_t value = 0;
+	if (!riscv32_abstract_command(hart, RV32_ABST_READ_S1) ||
+		!riscv_dm_read(hart->dbg_module, RV_DM_DATA0, &value))
+		return false;
+	riscv32_unpack_data(data + offset, value, access_width);
+	return true;
+}
+
+/* Write count values using the program buffer loop, which stores s1 to the address in s0 and advances s0 */
+static bool riscv32_progbuf_mem_write_block(riscv_hart_s *const hart, const target_addr_t dest,
+	const uint8_t *const data, const size_t count, const uint8_t access_width)
+{
+	const uint8_t access_length = 1U << access_width;
+	const size_t len = count << access_width;
+	/* Load the address into s0, then the first value into s1 running the loop to store it */
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA0, dest) || !riscv32_abstract_command(hart, RV32_ABST_WRITE_S0) ||
+		!riscv_dm_write(hart->dbg_module, RV_DM_DATA0, riscv32_pack_data(data, access_width)) ||
+		!riscv32_abstract_command(hart, RV32_ABST_WRITE_S1 | RV_REG_POSTEXEC))
+		return false;
+	if (count == 1U)
+		return true;
+	/* With autoexec, each write of data0 reruns the command, otherwise run it each time by hand */
+	if (hart->flags & RV_HART_FLAG_ABSTRACT_AUTO) {
+		if (!riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, RV_ABST_AUTO_DATA0))
+			return false;
+		bool result = true;
+		for (size_t offset = access_length; result && offset < len; offset += access_length)
+			result = riscv_dm_write(hart->dbg_module, RV_DM_DATA0, riscv32_pack_data(data + offset, access_width));
+		const bool complete = riscv_command_wait_complete(hart);
+		return riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, 0U) && result && complete;
+	}
+	for (size_t offset = access_length; offset < len; offset += access_length) {
+		if (!riscv_dm_write(hart->dbg_module, RV_DM_DATA0, riscv32_pack_data(data + offset, access_width)) ||
+			!riscv32_abstract_command(hart, RV32_ABST_WRITE_S1 | RV_REG_POSTEXEC))
+			return false;
+	}
+	return true;
+}
+
+static void riscv32_progbuf_mem_read(
+	riscv_hart_s *const hart, void *const dest, const target_addr_t src, const size_t len)
+{
+	static const uint32_t loads[] = {
+		0x00044483U, /* lbu s1, 0(s0) */
+		0x00045483U, /* lhu s1, 0(s0) */
+		0x00042483U, /* lw s1, 0(s0) */
+	};
+	const uint8_t access_width = riscv_mem_access_width(hart, src, len);
+	const uint32_t program[] = {loads[access_width], RV32_INSN_ADDI_S0(1U << access_width)};
+	/* The loop clobbers s0 and s1, so save them to restore afterwards */
+	uint32_t saved_s0 = 0;
+	uint32_t saved_s1 = 0;
+	if (!riscv_csr_read(hart, RV32_GPR_S0, &saved_s0) || !riscv_csr_read(hart, RV32_GPR_S1, &saved_s1))
+		return;
+	bool result = riscv_progbuf_load(hart, program, ARRAY_LENGTH(program)) &&
+		riscv32_progbuf_mem_read_block(hart, (uint8_t *)dest, src, len >> access_width, access_width);
+	/* If the DM couldn't keep up with autoexec, redo the block one command at a time */
+	if (!result && hart->status == RISCV_HART_BUSY && (hart->flags & RV_HART_FLAG_ABSTRACT_AUTO)) {
+		riscv32_abstract_auto_disable(hart);
+		result = riscv32_progbuf_mem_read_block(hart, (uint8_t *)dest, src, len >> access_width, access_width);
+	}
+	if (!result)
+		DEBUG_WARN("Program buffer memory read failed: %u\n", hart->status);
+	const riscv_hart_status_e status = hart->status;
+	riscv_csr_write(hart, RV32_GPR_S0, &saved_s0);
+	riscv_csr_write(hart, RV32_GPR_S1, &saved_s1);
+	hart->status = status;
+}
+
+static void riscv32_progbuf_mem_write(
+	riscv_hart_s *const hart, const target_addr_t dest, const void *const src, const size_t len)
+{
+	const uint8_t access_width = riscv_mem_access_width(hart, dest, len);
+	const uint32_t program[] = {RV32_INSN_STORE(access_width), RV32_INSN_ADDI_S0(1U << access_width)};
+	/* The loop clobbers s0 and s1, so save them to restore afterwards */
+	uint32_t saved_s0 = 0;
+	uint32_t saved_s1 = 0;
+	if (!riscv_csr_read(hart, RV32_GPR_S0, &saved_s0) || !riscv_csr_read(hart, RV32_GPR_S1, &saved_s1))
+		return;
+	bool result = riscv_progbuf_load(hart, program, ARRAY_LENGTH(program)) &&
+		riscv32_progbuf_mem_write_block(hart, dest, (const uint8_t *)src, len >> access_width, access_width);
+	/* If the DM couldn't keep up with autoexec, redo the block one command at a time */
+	if (!result && hart->status == RISCV_HART_BUSY && (hart->flags & RV_HART_FLAG_ABSTRACT_AUTO)) {
+		riscv32_abstract_auto_disable(hart);
+		result = riscv32_progbuf_mem_write_block(hart, dest, (const uint8_t *)src, len >> access_width, access_width);
+	}
+	if (!result)
+		DEBUG_WARN("Program buffer memory write failed: %u\n", hart->status);
+	const riscv_hart_status_e status = hart->status;
+	riscv_csr_write(hart, RV32_GPR_S0, &saved_s0);
+	riscv_csr_write(hart, RV32_GPR_S1, &saved_s1);
+	hart->status = status;
+}
+
 static void riscv_sysbus_check(riscv_hart_s *const hart)
 {
 	uint32_t status = 0;
@@ -278,12 +570,76 @@ static void riscv_sysbus_check(riscv_hart_s *const hart)
 		DEBUG_WARN("memory access failed: %u\n", hart->status);
 }
 
+/*
+ * Optimistically stream a block of reads from sbdata0 back to back without polling sbbusy between them,
+ * checking sbbusyerror and sberror only once at the end. Returns false if the block must be replayed with polling.
+ */
+static bool riscv32_sysbus_mem_burst_read(riscv_hart_s *const hart, uint8_t *const data, const target_addr_t src,
+	const size_t len, const uint32_t command, const uint8_t access_width)
+{
+	const uint8_t access_length = 1U << access_width;
+	const size_t last = len - access_length;
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, command) ||
+		!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_ADDR0, src))
+		return true;
+	bool result = true;
+	uint32_t values[RV32_PIPELINED_READ_CHUNK];
+	for (size_t offset = 0; result && offset < last;) {
+		const size_t count = MIN((last - offset) >> access_width, RV32_PIPELINED_READ_CHUNK);
+		result = riscv_dm_read_block(hart->dbg_module, RV_DM_SYSBUS_DATA0, values, count);
+		for (size_t index = 0; result && index < count; ++index, offset += access_length)
+			riscv32_unpack_data(data + offset, values[index], access_width);
+	}
+	if (!result)
+		return true;
+	/*
+	 * The last read of the block started the bus read for the final value, so wait for that to complete
+	 * before touching sbcs - the status read here is also what the block gets checked against
+	 */
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, 500U);
+	uint32_t status = RV_SYSBUS_STATUS_BUSY;
+	while (status & RV_SYSBUS_STATUS_BUSY) {
+		if (!riscv_dm_read(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, &status))
+			return true;
+		/* If the bus is wedged, give up on the read rather than hang */
+		if ((status & RV_SYSBUS_STATUS_BUSY) && platform_timeout_is_expired(&timeout)) {
+			DEBUG_WARN("System bus stuck busy, failing burst read\n");
+			hart->status = RISCV_HART_OTHER;
+			return true;
+		}
+	}
+	/* Turn off read on data so reading the final value doesn't start another bus read */
+	uint32_t value = 0;
+	if (!riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, 0) ||
+		!riscv_dm_read(hart->dbg_module, RV_DM_SYSBUS_DATA0, &value))
+		return true;
+	if (status & (RV_SYSBUS_STATUS_BUSY_ERROR | RV_SYSBUS_STATUS_ERROR_MASK)) {
+		/* If the bus couldn't keep up with us, stop trying to burst on this hart */
+		if (status & RV_SYSBUS_STATUS_BUSY_ERROR) {
+			DEBUG_WARN("System bus too slow for burst reads, disabling them\n");
+			hart->flags |= RV_HART_FLAG_SYSBUS_NO_BURST;
+		}
+		/* Clear the errors so the block can be replayed */
+		(void)riscv_dm_write(
+			hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, RV_SYSBUS_STATUS_BUSY_ERROR | RV_SYSBUS_STATUS_ERROR_MASK);
+		return false;
+	}
+	riscv32_unpack_data(data + last, value, access_width);
+	hart->status = RISCV_HART_NO_ERROR;
+	return true;
+}
+
 static void riscv32_sysbus_mem_native_read(riscv_hart_s *const hart, void *const dest, const target_addr_t src,
 	const size_t len, const uint8_t access_width, const uint8_t access_length)
 {
 	/* Build the access command */
 	const uint32_t command = ((uint32_t)access_width << RV_SYSBUS_MEM_ACCESS_SHIFT) | RV_SYSBUS_MEM_READ_ON_ADDR |
 		(access_length < len ? RV_SYSBUS_MEM_ADDR_POST_INC | RV_SYSBUS_MEM_READ_ON_DATA : 0U);
+	/* For multi-value reads, try a burst first and only fall back to polling each value if that fails */
+	if (access_length < len && !(hart->flags & RV_HART_FLAG_SYSBUS_NO_BURST) &&
+		riscv32_sysbus_mem_burst_read(hart, (uint8_t *)dest, src, len, command, access_width))
+		return;
 	/*
 	 * Write the command setup to the access control register
 	 * Then set up the read by writing the address to the address register
@@ -557,8 +913,17 @@ void riscv32_mem_read(target_s *const target, void *const dest, const target_add
 	riscv_hart_s *const hart = riscv_hart_struct(target);
 	if (hart->flags & RV_HART_FLAG_MEMORY_SYSBUS)
 		riscv32_sysbus_mem_read(hart, dest, src, len);
-	else
+	else if (hart->flags & RV_HART_FLAG_MEMORY_PROGBUF)
+		riscv32_progbuf_mem_read(hart, dest, src, len);
+	else {
 		riscv32_abstract_mem_read(hart, dest, src, len);
+		/* If the DM doesn't implement abstract memory access, switch over to using the program buffer */
+		if (hart->status == RISCV_HART_NOT_SUPP && riscv32_progbuf_usable(hart)) {
+			DEBUG_INFO("Abstract memory access not supported, using the program buffer\n");
+			hart->flags |= RV_HART_FLAG_MEMORY_PROGBUF;
+			riscv32_progbuf_mem_read(hart, dest, src, len);
+		}
+	}
 
 #if ENABLE_DEBUG
 	DEBUG_PROTO("%s: @ %08" PRIx32 " len %zu:", __func__, src, len);
@@ -599,8 +964,17 @@ void riscv32_mem_write(target_s *const target, const target_addr_t dest, const v
 	riscv_hart_s *const hart = riscv_hart_struct(target);
 	if (hart->flags & RV_HART_FLAG_MEMORY_SYSBUS)
 		riscv32_sysbus_mem_write(hart, dest, src, len);
-	else
+	else if (hart->flags & RV_HART_FLAG_MEMORY_PROGBUF)
+		riscv32_progbuf_mem_write(hart, dest, src, len);
+	else {
 		riscv32_abstract_mem_write(hart, dest, src, len);
+		/* If the DM doesn't implement abstract memory access, switch over to using the program buffer */
+		if (hart->status == RISCV_HART_NOT_SUPP && riscv32_progbuf_usable(hart)) {
+			DEBUG_INFO("Abstract memory access not supported, using the program buffer\n");
+			hart->flags |= RV_HART_FLAG_MEMORY_PROGBUF;
+			riscv32_progbuf_mem_write(hart, dest, src, len);
+		}
+	}
 }
 
 /*
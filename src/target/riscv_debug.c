@@ -69,9 +69,15 @@
 #define RV_DM_STAT_NON_EXISTENT   0x00004000U
 #define RV_DM_STAT_ALL_HALTED     0x00000200U
 #define RV_DM_STAT_ALL_RESET      0x00080000U
+#define RV_DM_STAT_IMPEBREAK      0x00400000U
 
-#define RV_DM_ABST_STATUS_BUSY       0x00001000U
-#define RV_DM_ABST_STATUS_DATA_COUNT 0x0000000fU
+#define RV_DM_ABST_STATUS_BUSY               0x00001000U
+#define RV_DM_ABST_STATUS_DATA_COUNT         0x0000000fU
+#define RV_DM_ABST_STATUS_PROGBUF_SIZE_MASK  0x1f000000U
+#define RV_DM_ABST_STATUS_PROGBUF_SIZE_SHIFT 24U
+
+/* ebreak, which ends execution of the program buffer */
+#define RV_INSN_EBREAK 0x00100073U
 
 #define RV_DM_SYSBUS_STATUS_ADDR_WIDTH_MASK 0x00000fe0U
 
@@ -442,6 +448,23 @@ static bool riscv_dmi_write(riscv_dmi_s *const dmi, const uint32_t address, cons
 	return dmi->write(dmi, address, value);
 }
 
+static bool riscv_dmi_read_block(
+	riscv_dmi_s *const dmi, const uint32_t address, uint32_t *const values, const size_t count)
+{
+	/* If the DMI can't pipeline repeated reads, fall back to reading one value at a time */
+	if (!dmi->read_block) {
+		for (size_t index = 0; index < count; ++index) {
+			if (!riscv_dmi_read(dmi, address, values + index))
+				return false;
+		}
+		return true;
+	}
+	const bool result = dmi->read_block(dmi, address, values, count);
+	if (result)
+		DEBUG_PROTO("%s: %08" PRIx32 " -> %zu values\n", __func__, address, count);
+	return result;
+}
+
 bool riscv_dm_read(riscv_dm_s *dbg_module, const uint8_t address, uint32_t *const value)
 {
 	return riscv_dmi_read(dbg_module->dmi_bus, dbg_module->base + address, value);
@@ -452,6 +475,11 @@ bool riscv_dm_write(riscv_dm_s *dbg_module, const uint8_t address, const uint32_
 	return riscv_dmi_write(dbg_module->dmi_bus, dbg_module->base + address, value);
 }
 
+bool riscv_dm_read_block(riscv_dm_s *dbg_module, const uint8_t address, uint32_t *const values, const size_t count)
+{
+	return riscv_dmi_read_block(dbg_module->dmi_bus, dbg_module->base + address, values, count);
+}
+
 static riscv_debug_version_e riscv_dm_version(const uint32_t status)
 {
 	uint8_t version = status & RV_STATUS_VERSION_MASK;
@@ -631,6 +659,28 @@ bool riscv_csr_write(riscv_hart_s *const hart, const uint16_t reg, const void *c
 	return riscv_command_wait_complete(hart);
 }
 
+/* Check if a program of count instructions, plus the ebreak to end it, fits in the program buffer */
+bool riscv_progbuf_fits(const riscv_hart_s *const hart, const size_t count)
+{
+	return count < hart->progbuf_size ||
+		(count == hart->progbuf_size && (hart->flags & RV_HART_FLAG_PROGBUF_IMPEBREAK));
+}
+
+/* Load a program into the program buffer, to be run by abstract commands with postexec set */
+bool riscv_progbuf_load(riscv_hart_s *const hart, const uint32_t *const program, const size_t count)
+{
+	if (!riscv_progbuf_fits(hart, count))
+		return false;
+	for (size_t index = 0; index < count; ++index) {
+		if (!riscv_dm_write(hart->dbg_module, RV_DM_PROGBUF0 + index, program[index]))
+			return false;
+	}
+	/* Unless the program fills the buffer and the DM ends it with an implicit ebreak, end it explicitly */
+	if (count < hart->progbuf_size)
+		return riscv_dm_write(hart->dbg_module, RV_DM_PROGBUF0 + count, RV_INSN_EBREAK);
+	return true;
+}
+
 uint8_t riscv_mem_access_width(const riscv_hart_s *const hart, const target_addr_t address, const size_t length)
 {
 	/* Grab the Hart's most maxmimally aligned possible write width */
@@ -711,7 +761,30 @@ static void riscv_hart_discover_triggers(riscv_hart_s *const hart)
 static void riscv_hart_memory_access_type(riscv_hart_s *const hart)
 {
 	uint32_t sysbus_status;
-	hart->flags &= (uint8_t)~RV_HART_FLAG_MEMORY_SYSBUS;
+	hart->flags &= (uint16_t)~(RV_HART_FLAG_MEMORY_SYSBUS | RV_HART_FLAG_ACCESS_WIDTH_MASK |
+		RV_HART_FLAG_ABSTRACT_AUTO | RV_HART_FLAG_SYSBUS_NO_BURST | RV_HART_FLAG_MEMORY_PROGBUF |
+		RV_HART_FLAG_PROGBUF_IMPEBREAK | RV_HART_FLAG_NO_REG_POSTINC);
+	/* Find out how big the program buffer is, and if the DM puts an implicit ebreak after it */
+	uint32_t abstract_status = 0;
+	uint32_t dm_status = 0;
+	if (riscv_dm_read(hart->dbg_module, RV_DM_ABST_CTRLSTATUS, &abstract_status) &&
+		riscv_dm_read(hart->dbg_module, RV_DM_STATUS, &dm_status)) {
+		hart->progbuf_size =
+			(abstract_status & RV_DM_ABST_STATUS_PROGBUF_SIZE_MASK) >> RV_DM_ABST_STATUS_PROGBUF_SIZE_SHIFT;
+		if (dm_status & RV_DM_STAT_IMPEBREAK)
+			hart->flags |= RV_HART_FLAG_PROGBUF_IMPEBREAK;
+		DEBUG_INFO("Hart has %u program buffer words%s\n", hart->progbuf_size,
+			(hart->flags & RV_HART_FLAG_PROGBUF_IMPEBREAK) ? " + implicit ebreak" : "");
+	}
+	/*
+	 * abstractauto is optional and its autoexecdata bits are WARL, so check data0's bit sticks.
+	 * If it does, abstract memory accesses can use it to do one DMI access per transfer.
+	 */
+	uint32_t abstract_auto = 0;
+	if (riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, RV_ABST_AUTO_DATA0) &&
+		riscv_dm_read(hart->dbg_module, RV_DM_ABST_AUTO, &abstract_auto) &&
+		riscv_dm_write(hart->dbg_module, RV_DM_ABST_AUTO, 0U) && (abstract_auto & RV_ABST_AUTO_DATA0))
+		hart->flags |= RV_HART_FLAG_ABSTRACT_AUTO;
 	/*
 	 * Try reading the system bus access control and status register.
 	 * Check if the value read back is non-zero for the sbasize field
@@ -720,9 +793,10 @@ static void riscv_hart_memory_access_type(riscv_hart_s *const hart)
 		!(sysbus_status & RV_DM_SYSBUS_STATUS_ADDR_WIDTH_MASK))
 		return;
 	/* If all the checks passed, we now have a valid system bus so can proceed with using it for memory access */
-	hart->flags = RV_HART_FLAG_MEMORY_SYSBUS | (sysbus_status & RV_HART_FLAG_ACCESS_WIDTH_MASK);
+	hart->flags |= RV_HART_FLAG_MEMORY_SYSBUS | (sysbus_status & RV_HART_FLAG_ACCESS_WIDTH_MASK);
 	/* Make sure the system bus is not in any kind of error state */
-	(void)riscv_dm_write(hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, 0x00407000U);
+	(void)riscv_dm_write(
+		hart->dbg_module, RV_DM_SYSBUS_CTRLSTATUS, RV_SYSBUS_STATUS_BUSY_ERROR | RV_SYSBUS_STATUS_ERROR_MASK);
 }
 
 riscv_match_size_e riscv_breakwatch_match_size(const size_t size)
@@ -92,6 +92,11 @@ typedef enum riscv_match_size {
 #define RV_HART_FLAG_ACCESS_WIDTH_16BIT 0x02U
 #define RV_HART_FLAG_ACCESS_WIDTH_32BIT 0x04U
 #define RV_HART_FLAG_ACCESS_WIDTH_64BIT 0x08U
+#define RV_HART_FLAG_ABSTRACT_AUTO      0x20U
+#define RV_HART_FLAG_SYSBUS_NO_BURST    0x40U
+#define RV_HART_FLAG_MEMORY_PROGBUF     0x80U
+#define RV_HART_FLAG_PROGBUF_IMPEBREAK  0x100U
+#define RV_HART_FLAG_NO_REG_POSTINC     0x200U
 
 typedef struct riscv_dmi riscv_dmi_s;
 
@@ -104,13 +109,19 @@ struct riscv_dmi {
 
 	uint8_t dev_index;
 	uint8_t idle_cycles;
+	uint8_t idle_cycles_min;
 	uint8_t address_width;
 	uint8_t fault;
+	bool write_pending;
+	uint16_t busy_free_scans;
+	uint32_t pending_address;
 
 	void (*prepare)(target_s *target);
 	void (*quiesce)(target_s *target);
 	bool (*read)(riscv_dmi_s *dmi, uint32_t address, uint32_t *value);
 	bool (*write)(riscv_dmi_s *dmi, uint32_t address, uint32_t value);
+	/* Optional, reads the same register repeatedly such as for abstract command autoexec */
+	bool (*read_block)(riscv_dmi_s *dmi, uint32_t address, uint32_t *values, size_t count);
 };
 
 /* This represents a specific Debug Module on the DMI bus */
@@ -131,7 +142,8 @@ typedef struct riscv_hart {
 	uint32_t hartsel;
 	uint8_t access_width;
 	uint8_t address_width;
-	uint8_t flags;
+	uint16_t flags;
+	uint8_t progbuf_size;
 	riscv_hart_status_e status;
 
 	uint32_t extensions;
@@ -152,6 +164,8 @@ typedef struct riscv_hart {
 #define RV_DM_DATA3             0x07U
 #define RV_DM_ABST_CTRLSTATUS   0x16U
 #define RV_DM_ABST_COMMAND      0x17U
+#define RV_DM_ABST_AUTO         0x18U
+#define RV_DM_PROGBUF0          0x20U
 #define RV_DM_SYSBUS_CTRLSTATUS 0x38U
 #define RV_DM_SYSBUS_ADDR0      0x39U
 #define RV_DM_SYSBUS_ADDR1      0x3aU
@@ -164,6 +178,8 @@ typedef struct riscv_hart {
 #define RV_ABST_READ          0x00000000U
 #define RV_ABST_WRITE         0x00010000U
 #define RV_REG_XFER           0x00020000U
+#define RV_REG_POSTEXEC       0x00040000U
+#define RV_REG_POSTINC        0x00080000U
 #define RV_REG_ACCESS_32_BIT  0x00200000U
 #define RV_REG_ACCESS_64_BIT  0x00300000U
 #define RV_REG_ACCESS_128_BIT 0x00400000U
@@ -177,10 +193,14 @@ typedef struct riscv_hart {
 #define RV_ABST_MEM_ADDR_POST_INC 0x00080000U
 #define RV_ABST_MEM_ACCESS_SHIFT  20U
 
+#define RV_ABST_AUTO_DATA0 0x00000001U
+
 #define RV_SYSBUS_MEM_ADDR_POST_INC 0x00010000U
 #define RV_SYSBUS_MEM_READ_ON_ADDR  0x00100000U
 #define RV_SYSBUS_MEM_READ_ON_DATA  0x00008000U
 #define RV_SYSBUS_STATUS_BUSY       0x00200000U
+#define RV_SYSBUS_STATUS_BUSY_ERROR 0x00400000U
+#define RV_SYSBUS_STATUS_ERROR_MASK 0x00007000U
 #define RV_SYSBUS_MEM_ACCESS_SHIFT  17U
 
 /* dpc -> Debug Program Counter */
@@ -220,9 +240,12 @@ riscv_hart_s *riscv_hart_struct(target_s *target);
 
 bool riscv_dm_read(riscv_dm_s *dbg_module, uint8_t address, uint32_t *value);
 bool riscv_dm_write(riscv_dm_s *dbg_module, uint8_t address, uint32_t value);
+bool riscv_dm_read_block(riscv_dm_s *dbg_module, uint8_t address, uint32_t *values, size_t count);
 bool riscv_command_wait_complete(riscv_hart_s *hart);
 bool riscv_csr_read(riscv_hart_s *hart, uint16_t reg, void *data);
 bool riscv_csr_write(riscv_hart_s *hart, uint16_t reg, const void *data);
+bool riscv_progbuf_fits(const riscv_hart_s *hart, size_t count);
+bool riscv_progbuf_load(riscv_hart_s *hart, const uint32_t *program, size_t count);
 riscv_match_size_e riscv_breakwatch_match_size(size_t size);
 bool riscv_config_trigger(
 	riscv_hart_s *hart, uint32_t trigger, riscv_trigger_state_e mode, const void *config, const void *address);
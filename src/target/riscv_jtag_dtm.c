@@ -58,10 +58,17 @@
 #define RV_DMI_FAILURE  2U
 #define RV_DMI_TOO_SOON 3U
 
+/* jtagtap_return_idle() can do at most 31 idle cycles in one go */
+#define RV_DMI_IDLE_CYCLES_MAX 31U
+/* Number of consecutive scans that must go without the DMI being busy before trying one fewer idle cycle */
+#define RV_DMI_IDLE_DECAY_SCANS 1024U
+
 static void riscv_jtag_dtm_init(riscv_dmi_s *dmi);
 static uint32_t riscv_shift_dtmcs(const riscv_dmi_s *dmi, uint32_t control);
 static bool riscv_jtag_dmi_read(riscv_dmi_s *dmi, uint32_t address, uint32_t *value);
 static bool riscv_jtag_dmi_write(riscv_dmi_s *dmi, uint32_t address, uint32_t value);
+static bool riscv_jtag_dmi_read_block(riscv_dmi_s *dmi, uint32_t address, uint32_t *values, size_t count);
+static void riscv_jtag_dmi_flush(riscv_dmi_s *dmi);
 static riscv_debug_version_e riscv_dtmcs_version(uint32_t dtmcs);
 
 static void riscv_jtag_prepare(target_s *target);
@@ -92,6 +99,8 @@ void riscv_jtag_dtm_handler(const uint8_t dev_index)
 	/* If we failed to find any DMs or Harts, free the structure */
 	if (!dmi->ref_count)
 		free(dmi);
+	else
+		riscv_jtag_dmi_flush(dmi);
 
 	/* Reset the JTAG machinery back to bypass to scan the next device in the chain */
 	jtag_dev_write_ir(dev_index, IR_BYPASS);
@@ -103,6 +112,7 @@ static void riscv_jtag_dtm_init(riscv_dmi_s *const dmi)
 	dmi->version = riscv_dtmcs_version(dtmcs);
 	/* Configure the TAP idle cylces based on what we've read */
 	dmi->idle_cycles = (dtmcs & RV_DTMCS_IDLE_CYCLES_MASK) >> RV_DTMCS_IDLE_CYCLES_SHIFT;
+	dmi->idle_cycles_min = dmi->idle_cycles;
 	/* And figure out how many address bits the DMI address space has */
 	dmi->address_width = (dtmcs & RV_DTMCS_ADDRESS_MASK) >> RV_DTMCS_ADDRESS_SHIFT;
 	/* Switch into DMI access mode for speed */
@@ -112,6 +122,7 @@ static void riscv_jtag_dtm_init(riscv_dmi_s *const dmi)
 	dmi->quiesce = riscv_jtag_quiesce;
 	dmi->read = riscv_jtag_dmi_read;
 	dmi->write = riscv_jtag_dmi_write;
+	dmi->read_block = riscv_jtag_dmi_read_block;
 
 	riscv_dmi_init(dmi);
 }
@@ -155,67 +166,129 @@ static uint8_t riscv_shift_dmi(riscv_dmi_s *const dmi, const uint8_t operation,
 	return status;
 }
 
-static bool riscv_dmi_transfer(riscv_dmi_s *const dmi, const uint8_t operation, const uint32_t address,
+/* Called when the DMI was found busy to increase the idle cycles, returns false if we're already at the limit */
+static bool riscv_dmi_back_off(riscv_dmi_s *const dmi)
+{
+	dmi->busy_free_scans = 0;
+	if (dmi->idle_cycles == RV_DMI_IDLE_CYCLES_MAX)
+		return false;
+	/* Back off exponentially so we quickly catch up with how slow the DM is */
+	dmi->idle_cycles = dmi->idle_cycles ? MIN(dmi->idle_cycles * 2U, RV_DMI_IDLE_CYCLES_MAX) : 1U;
+	DEBUG_TARGET("DMI busy, now using %u idle cycles\n", dmi->idle_cycles);
+	return true;
+}
+
+/* Called after each scan that wasn't busy, to try fewer idle cycles again after a long enough busy-free run */
+static void riscv_dmi_idle_decay(riscv_dmi_s *const dmi)
+{
+	if (dmi->idle_cycles <= dmi->idle_cycles_min || ++dmi->busy_free_scans < RV_DMI_IDLE_DECAY_SCANS)
+		return;
+	--dmi->idle_cycles;
+	dmi->busy_free_scans = 0;
+}
+
+/*
+ * Shift in a DMI operation while capturing the result of the one before it. If that previous operation was
+ * still in progress, the DTM ignores this one and goes sticky busy. When that happens we back off the idle
+ * cycles, clear the busy state, collect the previous result once it's done, and then reissue this operation.
+ * The previous operation is never reissued as accesses such as reads of data0 can have side effects.
+ */
+static uint8_t riscv_dmi_scan(riscv_dmi_s *const dmi, const uint8_t operation, const uint32_t address,
 	const uint32_t data_in, uint32_t *const data_out)
 {
-	/* Try the transfer */
 	uint8_t status = riscv_shift_dmi(dmi, operation, address, data_in, data_out);
-
-	/* Handle status == 3 (RV_DMI_TOO_SOON) */
-	if (status == RV_DMI_TOO_SOON) {
-		/*
-		 * If we got RV_DMI_TOO_SOON and we're under 8 idle cycles, increase the number
-		 * of idle cycles used to compensate and have the outer code re-run the transnfers
-		 */
-		if (dmi->idle_cycles < 8)
-			++dmi->idle_cycles;
-		/*
-		 * Otherwise we've hit 8 idle cycles, it doesn't matter if we get another
-		 * RV_DMI_TOO_SOON, treat that as a hard error and bail out.
-		 */
-		else
+	bool reissue = false;
+	while (status == RV_DMI_TOO_SOON) {
+		riscv_dmi_reset(dmi);
+		if (!riscv_dmi_back_off(dmi)) {
 			status = RV_DMI_FAILURE;
+			break;
+		}
+		reissue = true;
+		status = riscv_shift_dmi(dmi, RV_DMI_NOOP, 0U, 0U, data_out);
 	}
 
-	dmi->fault = status;
-	/* If we get straight failure, do a DMI reset */
-	if (status == RV_DMI_FAILURE || status == RV_DMI_TOO_SOON)
+	if (status == RV_DMI_SUCCESS) {
+		riscv_dmi_idle_decay(dmi);
+		/* The NOOP we just did can't leave the DMI busy, so this can't fail */
+		if (reissue)
+			(void)riscv_shift_dmi(dmi, operation, address, data_in, NULL);
+	} else if (status == RV_DMI_FAILURE)
+		/* If we get straight failure, do a DMI reset */
 		riscv_dmi_reset(dmi);
-	return status == RV_DMI_SUCCESS;
+	dmi->fault = status;
+	return status;
+}
+
+/*
+ * Issue a DMI operation whose result is collected by the next scan. As writes are posted, this also picks up
+ * the status of any write still in flight, which is what a failure here is then reporting on.
+ */
+static bool riscv_dmi_issue(riscv_dmi_s *const dmi, const uint8_t operation, const uint32_t address,
+	const uint32_t data_in)
+{
+	const bool result = riscv_dmi_scan(dmi, operation, address, data_in, NULL) == RV_DMI_SUCCESS;
+	if (!result && dmi->write_pending)
+		DEBUG_WARN("DMI write at 0x%08" PRIx32 " failed with status %u\n", dmi->pending_address, dmi->fault);
+	dmi->write_pending = false;
+	return result;
 }
 
 static bool riscv_jtag_dmi_read(riscv_dmi_s *const dmi, const uint32_t address, uint32_t *const value)
 {
-	bool result = true;
-	do {
-		/* Setup the location to read from */
-		result = riscv_dmi_transfer(dmi, RV_DMI_READ, address, 0, NULL);
-		if (result)
-			/* If that worked, read back the value and check the operation status */
-			result = riscv_dmi_transfer(dmi, RV_DMI_NOOP, 0, 0, value);
-	} while (dmi->fault == RV_DMI_TOO_SOON);
+	/* Setup the location to read from */
+	bool result = riscv_dmi_issue(dmi, RV_DMI_READ, address, 0U);
+	if (result)
+		/* If that worked, read back the value and check the operation status */
+		result = riscv_dmi_scan(dmi, RV_DMI_NOOP, 0U, 0U, value) == RV_DMI_SUCCESS;
 
 	if (!result)
 		DEBUG_WARN("DMI read at 0x%08" PRIx32 " failed with status %u\n", address, dmi->fault);
 	return result;
 }
 
-static bool riscv_jtag_dmi_write(riscv_dmi_s *const dmi, const uint32_t address, const uint32_t value)
+/*
+ * Read the same DMI register count times, with each scan issuing the next read while collecting the result
+ * of the one before it. This takes count + 1 scans rather than the 2 per value of doing individual reads.
+ */
+static bool riscv_jtag_dmi_read_block(
+	riscv_dmi_s *const dmi, const uint32_t address, uint32_t *const values, const size_t count)
 {
-	bool result = true;
-	do {
-		/* Write a value to the requested register */
-		result = riscv_dmi_transfer(dmi, RV_DMI_WRITE, address, value, NULL);
-		if (result)
-			/* If that worked, read back the operation status to ensure the write actually worked */
-			result = riscv_dmi_transfer(dmi, RV_DMI_NOOP, 0, 0, NULL);
-	} while (dmi->fault == RV_DMI_TOO_SOON);
+	if (!count)
+		return true;
+	bool result = riscv_dmi_issue(dmi, RV_DMI_READ, address, 0U);
+	for (size_t index = 0; result && index < count; ++index) {
+		const uint8_t operation = index + 1U < count ? RV_DMI_READ : RV_DMI_NOOP;
+		result = riscv_dmi_scan(dmi, operation, address, 0U, values + index) == RV_DMI_SUCCESS;
+	}
 
 	if (!result)
-		DEBUG_WARN("DMI write at 0x%08" PRIx32 " failed with status %u\n", address, dmi->fault);
+		DEBUG_WARN("DMI block read at 0x%08" PRIx32 " failed with status %u\n", address, dmi->fault);
 	return result;
 }
 
+static bool riscv_jtag_dmi_write(riscv_dmi_s *const dmi, const uint32_t address, const uint32_t value)
+{
+	/*
+	 * Write a value to the requested register. The write is posted, so rather than spending a scan
+	 * on reading back its status here, the next operation's scan picks that up
+	 */
+	if (!riscv_dmi_issue(dmi, RV_DMI_WRITE, address, value)) {
+		DEBUG_WARN("DMI write at 0x%08" PRIx32 " not performed\n", address);
+		return false;
+	}
+	dmi->write_pending = true;
+	dmi->pending_address = address;
+	return true;
+}
+
+/* Collect the status of any posted write before the TAP gets switched away from the DMI */
+static void riscv_jtag_dmi_flush(riscv_dmi_s *const dmi)
+{
+	if (dmi->write_pending)
+		(void)riscv_dmi_issue(dmi, RV_DMI_NOOP, 0U, 0U);
+}
+
 static riscv_debug_version_e riscv_dtmcs_version(const uint32_t dtmcs)
 {
 	uint8_t version = dtmcs & RV_STATUS_VERSION_MASK;
@@ -243,6 +316,7 @@ static void riscv_jtag_prepare(target_s *const target)
 static void riscv_jtag_quiesce(target_s *const target)
 {
 	riscv_hart_s *const hart = riscv_hart_struct(target);
+	riscv_jtag_dmi_flush(hart->dbg_module->dmi_bus);
 	/* On detaching, stick the TAP back into bypass */
 	jtag_dev_write_ir(hart->dbg_module->dmi_bus->dev_index, IR_BYPASS);
 }
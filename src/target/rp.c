@@ -118,6 +118,7 @@
 #define RP_SSI_XIP_SPI_CTRL0_ADDRESS_LENGTH(x) (((x)*2U) << 2U)
 #define RP_SSI_XIP_SPI_CTRL0_INSTR_LENGTH_8b   (2U << 8U)
 #define RP_SSI_XIP_SPI_CTRL0_WAIT_CYCLES(x)    (((x)*8U) << 11U)
+#define RP_SSI_XIP_SPI_CTRL0_WAIT_CLOCKS(x)    (((x)&0x1fU) << 11U)
 #define RP_SSI_XIP_SPI_CTRL0_XIP_CMD_SHIFT     24U
 #define RP_SSI_XIP_SPI_CTRL0_XIP_CMD(x)        ((x) << RP_SSI_XIP_SPI_CTRL0_XIP_CMD_SHIFT)
 #define RP_SSI_XIP_SPI_CTRL0_TRANS_1C1A        (0U << 0U)
@@ -161,12 +162,29 @@
 #define MAX_FLASH                (16U * 1024U * 1024U)
 #define MAX_WRITE_CHUNK          0x1000U
 
+/* Bootrom Flash routines are run with data staged at the bottom of SRAM and the stack at the top */
+#define RP_ROM_CALL_BUFFER         RP_SRAM_BASE
+#define RP_ROM_CALL_STACK          (RP_SRAM_BASE + RP_SRAM_SIZE)
+#define RP_ROM_CALL_TIMEOUT        500U
+#define RP_ROM_ERASE_TIMEOUT       2000U
+#define RP_ROM_ERASE_BLOCK_SIZE    FLASHSIZE_64K_BLOCK
+#define RP_ROM_ERASE_BLOCK_COMMAND 0xd8U
+
 typedef struct rp_priv {
 	uint16_t rom_reset_usb_boot;
+	uint16_t rom_debug_trampoline;
+	uint16_t rom_debug_trampoline_end;
+	uint16_t rom_connect_internal_flash;
+	uint16_t rom_flash_exit_xip;
+	uint16_t rom_flash_range_erase;
+	uint16_t rom_flash_range_program;
 	uint32_t ssi_enabled;
 	uint32_t ctrl0;
 	uint32_t ctrl1;
 	uint32_t xpi_ctrl0;
+	/* Read command and frame format to use for XIP when we configure it */
+	spi_fast_read_s xip_read;
+	uint32_t xip_frame_format;
 } rp_priv_s;
 
 static bool rp_cmd_erase_sector(target_s *target, int argc, const char **argv);
@@ -181,6 +199,7 @@ const command_s rp_cmd_list[] = {
 static bool rp_read_rom_func_table(target_s *target);
 static bool rp_attach(target_s *target);
 static void rp_spi_config(target_s *target);
+static void rp_spi_command_mode(target_s *target);
 static void rp_spi_restore(target_s *target);
 static bool rp_flash_prepare(target_s *target);
 static bool rp_flash_resume(target_s *target);
@@ -188,6 +207,10 @@ static void rp_spi_read(target_s *target, uint16_t command, target_addr_t addres
 static void rp_spi_write(target_s *target, uint16_t command, target_addr_t address, const void *buffer, size_t length);
 static void rp_spi_run_command(target_s *target, uint16_t command, target_addr_t address);
 static uint32_t rp_get_flash_length(target_s *target);
+static bool rp_rom_flash_available(const rp_priv_s *priv);
+static bool rp_rom_flash_erase(target_flash_s *flash, target_addr_t addr, size_t length);
+static bool rp_rom_flash_write(target_flash_s *flash, target_addr_t dest, const void *src, size_t length);
+static bool rp_flash_map(target_flash_s *flash, bool mapped);
 
 static bool rp_flash_in_por_state(target_s *target);
 // Our own implementation of bootloader functions for handling flash chip
@@ -205,8 +228,33 @@ static void rp_add_flash(target_s *target)
 	rp_flash_exit_xip(target);
 	rp_spi_config(target);
 
-	bmp_spi_add_flash(
+	spi_flash_s *const spi_flash = bmp_spi_add_flash(
 		target, RP_XIP_FLASH_BASE, rp_get_flash_length(target), rp_spi_read, rp_spi_write, rp_spi_run_command);
+	rp_priv_s *const priv = (rp_priv_s *)target->target_storage;
+	memset(&priv->xip_read, 0, sizeof(priv->xip_read));
+	priv->xip_frame_format = RP_SSI_CTRL0_FRF_SERIAL;
+	if (spi_flash) {
+		/*
+		 * The SSI can run XIP reads with a serial command and address and a dual or quad data phase,
+		 * so find the widest such read the Flash can do to speed up reads through the XIP window.
+		 * The SSI only applies the dummy cycles of a fast read in its dual and quad frame formats,
+		 * so without one of those plain 03h reads are used instead.
+		 */
+		const spi_read_mode_e read_mode = bmp_spi_select_read_mode(
+			target, spi_flash, SPI_READ_MODE_MASK(SPI_READ_MODE_1_1_2) | SPI_READ_MODE_MASK(SPI_READ_MODE_1_1_4));
+		if (read_mode != SPI_READ_MODE_COUNT) {
+			priv->xip_read = spi_flash->fast_reads[read_mode];
+			priv->xip_frame_format = read_mode == SPI_READ_MODE_1_1_4 ? RP_SSI_CTRL0_FRF_QUAD : RP_SSI_CTRL0_FRF_DUAL;
+		}
+	}
+	/* If the bootrom provides the Flash routines, let the core do the heavy lifting for erase and write */
+	if (spi_flash && rp_rom_flash_available(priv)) {
+		spi_flash->flash.erase = rp_rom_flash_erase;
+		spi_flash->flash.write = rp_rom_flash_write;
+	}
+	/* Reads during a Flash session (eg, for verification) can then go through the XIP window */
+	if (spi_flash)
+		spi_flash->flash.map = rp_flash_map;
 
 	rp_spi_restore(target);
 	if (por_state)
@@ -270,18 +318,108 @@ static bool rp_read_rom_func_table(target_s *const target)
 	/* We have to do a 32-bit read here but the pointer contained is only 16-bit. */
 	const uint16_t table_offset = target_mem_read32(target, BOOTROM_FUNC_TABLE_ADDR) & 0x0000ffffU;
 	uint16_t table[RP_MAX_TABLE_SIZE];
-	if (target_mem_read(target, table, table_offset, RP_MAX_TABLE_SIZE))
+	if (target_mem_read(target, table, table_offset, sizeof(table)))
 		return false;
 
 	for (size_t i = 0; i < RP_MAX_TABLE_SIZE; i += 2U) {
 		const uint16_t tag = table[i];
 		const uint16_t addr = table[i + 1U];
-		if (tag == BOOTROM_FUNC_TABLE_TAG('U', 'B')) {
+		/* A null tag marks the end of the table */
+		if (!tag)
+			break;
+		if (tag == BOOTROM_FUNC_TABLE_TAG('U', 'B'))
 			priv->rom_reset_usb_boot = addr;
-			return true;
+		else if (tag == BOOTROM_FUNC_TABLE_TAG('D', 'T'))
+			priv->rom_debug_trampoline = addr;
+		else if (tag == BOOTROM_FUNC_TABLE_TAG('D', 'E'))
+			priv->rom_debug_trampoline_end = addr;
+		else if (tag == BOOTROM_FUNC_TABLE_TAG('I', 'F'))
+			priv->rom_connect_internal_flash = addr;
+		else if (tag == BOOTROM_FUNC_TABLE_TAG('E', 'X'))
+			priv->rom_flash_exit_xip = addr;
+		else if (tag == BOOTROM_FUNC_TABLE_TAG('R', 'E'))
+			priv->rom_flash_range_erase = addr;
+		else if (tag == BOOTROM_FUNC_TABLE_TAG('R', 'P'))
+			priv->rom_flash_range_program = addr;
+	}
+	return priv->rom_reset_usb_boot != 0U;
+}
+
+static bool rp_rom_flash_available(const rp_priv_s *const priv)
+{
+	return priv->rom_debug_trampoline && priv->rom_debug_trampoline_end && priv->rom_connect_internal_flash &&
+		priv->rom_flash_exit_xip && priv->rom_flash_range_erase && priv->rom_flash_range_program;
+}
+
+/*
+ * Run a bootrom routine on the core. This goes via the ROM's debug trampoline which calls the function
+ * pointer in r7 and then hits a breakpoint at the trampoline's end, handing control back to us.
+ */
+static bool rp_rom_call(target_s *const target, const uint16_t function, const uint32_t arg0, const uint32_t arg1,
+	const uint32_t arg2, const uint32_t arg3, const uint32_t timeout_ms)
+{
+	const rp_priv_s *const priv = (rp_priv_s *)target->target_storage;
+	uint32_t regs[CORTEXM_GENERAL_REG_COUNT] = {0};
+	regs[0] = arg0;
+	regs[1] = arg1;
+	regs[2] = arg2;
+	regs[3] = arg3;
+	regs[7] = function;
+	/* Strip the Thumb bit from the trampoline address as we're loading it straight into the PC */
+	regs[CORTEX_REG_PC] = priv->rom_debug_trampoline & ~1U;
+	regs[CORTEX_REG_LR] = priv->rom_debug_trampoline_end;
+	regs[CORTEX_REG_SP] = RP_ROM_CALL_STACK;
+	regs[CORTEX_REG_MSP] = RP_ROM_CALL_STACK;
+	regs[CORTEX_REG_XPSR] = CORTEXM_XPSR_THUMB;
+	/* Set PRIMASK so nothing can interrupt the routine and try to execute from Flash */
+	regs[CORTEX_REG_SPECIAL] = 1U;
+	target_regs_write(target, regs);
+	if (target_check_error(target))
+		return false;
+
+	target_halt_resume(target, false);
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, timeout_ms);
+	target_halt_reason_e reason = TARGET_HALT_RUNNING;
+	while (reason == TARGET_HALT_RUNNING) {
+		if (platform_timeout_is_expired(&timeout)) {
+			target_halt_request(target);
+			DEBUG_ERROR("RP2040 bootrom call to %04x timed out\n", function);
+			return false;
 		}
+		reason = target_halt_poll(target, NULL);
 	}
-	return false;
+	if (reason != TARGET_HALT_BREAKPOINT)
+		return false;
+	/* Make sure the breakpoint we stopped on is the one at the end of the trampoline */
+	uint32_t pc = 0;
+	target_reg_read(target, CORTEX_REG_PC, &pc, sizeof(pc));
+	return (pc & ~1U) == (priv->rom_debug_trampoline_end & ~1U);
+}
+
+static bool rp_rom_flash_erase(target_flash_s *const flash, const target_addr_t addr, const size_t length)
+{
+	target_s *const target = flash->t;
+	const rp_priv_s *const priv = (rp_priv_s *)target->target_storage;
+	/* flash_range_erase() only copes with whole sectors, so round the range out to sector boundaries */
+	const uint32_t begin = (addr - flash->start) & ~(FLASHSIZE_4K_SECTOR - 1U);
+	const uint32_t end = (addr - flash->start + length + FLASHSIZE_4K_SECTOR - 1U) & ~(FLASHSIZE_4K_SECTOR - 1U);
+	/* It then uses block erases for any 64KiB aligned parts of the range and sector erases for the rest */
+	const uint32_t timeout = RP_ROM_ERASE_TIMEOUT * (1U + (end - begin) / RP_ROM_ERASE_BLOCK_SIZE);
+	return rp_rom_call(target, priv->rom_flash_range_erase, begin, end - begin, RP_ROM_ERASE_BLOCK_SIZE,
+		RP_ROM_ERASE_BLOCK_COMMAND, timeout);
+}
+
+static bool rp_rom_flash_write(
+	target_flash_s *const flash, const target_addr_t dest, const void *const src, const size_t length)
+{
+	target_s *const target = flash->t;
+	const rp_priv_s *const priv = (rp_priv_s *)target->target_storage;
+	/* Stage the block in SRAM in one go, then have flash_range_program() write it out */
+	if (target_mem_write(target, RP_ROM_CALL_BUFFER, src, length))
+		return false;
+	return rp_rom_call(target, priv->rom_flash_range_program, dest - flash->start, RP_ROM_CALL_BUFFER, length, 0U,
+		RP_ROM_CALL_TIMEOUT);
 }
 
 static void rp_spi_config(target_s *const target)
@@ -293,6 +431,13 @@ static void rp_spi_config(target_s *const target)
 	priv->ctrl0 = target_mem_read32(target, RP_SSI_CTRL0);
 	priv->ctrl1 = target_mem_read32(target, RP_SSI_CTRL1);
 	priv->xpi_ctrl0 = target_mem_read32(target, RP_SSI_XIP_SPI_CTRL0);
+	rp_spi_command_mode(target);
+}
+
+static void rp_spi_command_mode(target_s *const target)
+{
+	const rp_priv_s *const priv = (rp_priv_s *)target->target_storage;
+	target_mem_write32(target, RP_SSI_ENABLE, 0);
 	target_mem_write32(target, RP_SSI_CTRL0,
 		(priv->ctrl0 & RP_SSI_CTRL0_MASK) | RP_SSI_CTRL0_FRF_SERIAL | RP_SSI_CTRL0_TMOD_BIDI |
 			RP_SSI_CTRL0_DATA_BITS(8));
@@ -316,9 +461,16 @@ static void rp_spi_restore(target_s *const target)
 static bool rp_flash_prepare(target_s *const target)
 {
 	DEBUG_TARGET("%s\n", __func__);
-	/* Suspend the cache, come out of XIP */
-	rp_flash_connect_internal(target);
-	rp_flash_exit_xip(target);
+	const rp_priv_s *const priv = (rp_priv_s *)target->target_storage;
+	/* Suspend the cache, come out of XIP - on the core if we can, as that's far faster than doing it over SWD */
+	if (rp_rom_flash_available(priv)) {
+		if (!rp_rom_call(target, priv->rom_connect_internal_flash, 0U, 0U, 0U, 0U, RP_ROM_CALL_TIMEOUT) ||
+			!rp_rom_call(target, priv->rom_flash_exit_xip, 0U, 0U, 0U, 0U, RP_ROM_CALL_TIMEOUT))
+			return false;
+	} else {
+		rp_flash_connect_internal(target);
+		rp_flash_exit_xip(target);
+	}
 	/* Configure the SPI controller for our use */
 	rp_spi_config(target);
 	return true;
@@ -336,6 +488,22 @@ static bool rp_flash_resume(target_s *const target)
 	return true;
 }
 
+static bool rp_flash_map(target_flash_s *const flash, const bool mapped)
+{
+	target_s *const target = flash->t;
+	/*
+	 * Our XIP configuration leaves the Flash taking serial commands, so switching between XIP reads
+	 * and command mode is only a matter of reconfiguring the SSI. Flush the cache on the way into
+	 * XIP so reads see what was just programmed rather than stale lines.
+	 */
+	if (mapped) {
+		rp_flash_flush_cache(target);
+		rp_flash_enter_xip(target);
+	} else
+		rp_spi_command_mode(target);
+	return true;
+}
+
 static void rp_spi_chip_select(target_s *const target, const uint32_t state)
 {
 	const uint32_t value = target_mem_read32(target, RP_GPIO_QSPI_CS_CTRL);
@@ -597,22 +765,26 @@ static void rp_flash_flush_cache(target_s *const target)
 	rp_spi_chip_select(target, RP_GPIO_QSPI_CS_DRIVE_NORMAL);
 }
 
-// Put the SSI into a mode where XIP accesses translate to standard
-// serial 03h read commands. The flash remains in its default serial command
-// state, so will still respond to other commands.
+// Put the SSI into a mode where XIP accesses translate to the fastest read
+// command found for the Flash with a serial command and address phase, or
+// standard serial 03h reads if there is none. The flash remains in its default
+// serial command state, so will still respond to other commands.
 static void rp_flash_enter_xip(target_s *const target)
 {
+	const rp_priv_s *const priv = (rp_priv_s *)target->target_storage;
+	const uint8_t read_opcode = priv->xip_read.opcode ? priv->xip_read.opcode : 0x03U;
 	target_mem_write32(target, RP_SSI_ENABLE, 0);
 	target_mem_write32(target, RP_SSI_CTRL0,
-		RP_SSI_CTRL0_FRF_SERIAL |         // Standard 1-bit SPI serial frames
+		priv->xip_frame_format |          // Frame format for the data phase
 			RP_SSI_CTRL0_DATA_BITS(32U) | // 32 clocks per data frame
 			RP_SSI_CTRL0_TMOD_EEPROM      // Send instr + addr, receive data
 	);
 	target_mem_write32(target, RP_SSI_XIP_SPI_CTRL0,
-		RP_SSI_XIP_SPI_CTRL0_XIP_CMD(0x03U) |            // Standard 03h read
-			RP_SSI_XIP_SPI_CTRL0_INSTR_LENGTH_8b |       // 8-bit instruction prefix
-			RP_SSI_XIP_SPI_CTRL0_ADDRESS_LENGTH(0x03U) | // 24-bit addressing for 03h commands
-			RP_SSI_XIP_SPI_CTRL0_TRANS_1C1A              // Command and address both in serial format
+		RP_SSI_XIP_SPI_CTRL0_XIP_CMD(read_opcode) |                         // Read command to use
+			RP_SSI_XIP_SPI_CTRL0_INSTR_LENGTH_8b |                          // 8-bit instruction prefix
+			RP_SSI_XIP_SPI_CTRL0_ADDRESS_LENGTH(0x03U) |                    // 24-bit addressing
+			RP_SSI_XIP_SPI_CTRL0_WAIT_CLOCKS(priv->xip_read.dummy_cycles) | // Dummy cycles for fast reads
+			RP_SSI_XIP_SPI_CTRL0_TRANS_1C1A                                 // Command and address in serial format
 	);
 	target_mem_write32(target, RP_SSI_ENABLE, RP_SSI_ENABLE_SSI);
 }
@@ -49,6 +49,7 @@
 #include "semihosting.h"
 #include "semihosting_internal.h"
 #include "buffer_utils.h"
+#include "hex_utils.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -74,6 +75,18 @@ uint32_t semihosting_wallclock_epoch = UINT32_MAX;
 /* This stores the current :semihosting-features "file" access offset */
 static uint8_t semihosting_features_offset = 0U;
 
+/*
+ * When stdout is redirected, console writes are copied into this buffer in bulk and the target
+ * resumed straight away - the buffer is then drained to the aux serial or GDB console while it runs.
+ */
+static uint8_t semihosting_stdout_buffer[SEMIHOSTING_STDOUT_BUFFER_SIZE];
+static size_t semihosting_stdout_head = 0U;
+static size_t semihosting_stdout_tail = 0U;
+static size_t semihosting_stdout_used = 0U;
+static bool semihosting_stdout_to_console = false;
+/* Set when a flush gave up because nothing was reading the output */
+static bool semihosting_stdout_stalled = false;
+
 /*
  * "SHFB" is the magic number header for the :semihosting-features "file"
  * Following that comes a byte of feature bits:
@@ -190,22 +203,137 @@ static int32_t semihosting_get_gdb_response(target_controller_s *const tc)
 	}
 }
 
+static bool semihosting_stdout_is_buffered(const target_s *const target, const int32_t fd)
+{
+	if (!target->stdout_redirected || (fd != STDOUT_FILENO && fd != STDERR_FILENO))
+		return false;
+#if PC_HOSTED == 1
+	/* BMDA writes straight to its own stdout, so only the GDB console needs buffering */
+	return target->stdout_console;
+#else
+	return true;
+#endif
+}
+
+/* Hand a contiguous chunk of buffered output to the sink, returning how much it accepted */
+static size_t semihosting_stdout_emit(const uint8_t *const data, const size_t len)
+{
+	if (semihosting_stdout_to_console) {
+		char hex_buffer[SEMIHOSTING_CONSOLE_CHUNK_SIZE * 2U + 1U];
+		const size_t amount = MIN(len, SEMIHOSTING_CONSOLE_CHUNK_SIZE);
+		hexify(hex_buffer, data, amount);
+		gdb_putpacket2("O", 1U, hex_buffer, amount * 2U);
+		return amount;
+	}
+#if PC_HOSTED == 0
+	return debug_serial_send_stdout(data, len);
+#else
+	const ssize_t result = write(STDOUT_FILENO, data, len);
+	/* If the write failed there's nothing useful to do with the data, so discard it */
+	return result > 0 ? (size_t)result : len;
+#endif
+}
+
+/*
+ * Push buffered output to the sink for as long as it keeps accepting data. With wait set, keep
+ * retrying until everything is out, dropping the output if the sink stops taking it for too long.
+ */
+void semihosting_stdout_flush(const bool wait)
+{
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, SEMIHOSTING_STDOUT_FLUSH_TIMEOUT);
+	while (semihosting_stdout_used) {
+		const size_t chunk = MIN(semihosting_stdout_used, SEMIHOSTING_STDOUT_BUFFER_SIZE - semihosting_stdout_tail);
+		const size_t sent = semihosting_stdout_emit(semihosting_stdout_buffer + semihosting_stdout_tail, chunk);
+		semihosting_stdout_tail = (semihosting_stdout_tail + sent) % SEMIHOSTING_STDOUT_BUFFER_SIZE;
+		semihosting_stdout_used -= sent;
+		if (sent) {
+			/* Something is reading the output again, so it's worth waiting on the sink */
+			semihosting_stdout_stalled = false;
+			platform_timeout_set(&timeout, SEMIHOSTING_STDOUT_FLUSH_TIMEOUT);
+			continue;
+		}
+		if (!wait)
+			break;
+		/*
+		 * If the sink has stopped accepting data (nobody has the aux serial open), drop what's left. Once that's
+		 * happened, don't wait out the timeout again until the sink has been seen taking data.
+		 */
+		if (semihosting_stdout_stalled || platform_timeout_is_expired(&timeout)) {
+			semihosting_stdout_stalled = true;
+			semihosting_stdout_tail = semihosting_stdout_head;
+			semihosting_stdout_used = 0U;
+		}
+	}
+}
+
+/* Copy data already on the probe into the output buffer, flushing when it fills */
+static void semihosting_stdout_push(const target_s *const target, const uint8_t *const data, const size_t len)
+{
+	semihosting_stdout_to_console = target->stdout_console;
+	for (size_t offset = 0; offset < len;) {
+		if (semihosting_stdout_used == SEMIHOSTING_STDOUT_BUFFER_SIZE)
+			semihosting_stdout_flush(true);
+		const size_t amount = MIN(len - offset,
+			MIN(SEMIHOSTING_STDOUT_BUFFER_SIZE - semihosting_stdout_used,
+				SEMIHOSTING_STDOUT_BUFFER_SIZE - semihosting_stdout_head));
+		memcpy(semihosting_stdout_buffer + semihosting_stdout_head, data + offset, amount);
+		semihosting_stdout_head = (semihosting_stdout_head + amount) % SEMIHOSTING_STDOUT_BUFFER_SIZE;
+		semihosting_stdout_used += amount;
+		offset += amount;
+	}
+}
+
+/* Read a console write from the target straight into the output buffer in as few accesses as possible */
+static int32_t semihosting_stdout_write(target_s *const target, const target_addr_t buf_taddr, const uint32_t count)
+{
+	semihosting_stdout_to_console = target->stdout_console;
+	for (uint32_t offset = 0; offset < count;) {
+		if (semihosting_stdout_used == SEMIHOSTING_STDOUT_BUFFER_SIZE)
+			semihosting_stdout_flush(true);
+		const size_t amount = MIN(count - offset,
+			MIN(SEMIHOSTING_STDOUT_BUFFER_SIZE - semihosting_stdout_used,
+				SEMIHOSTING_STDOUT_BUFFER_SIZE - semihosting_stdout_head));
+		if (target_mem_read(target, semihosting_stdout_buffer + semihosting_stdout_head, buf_taddr + offset, amount))
+			return offset ? (int32_t)offset : -1;
+		semihosting_stdout_head = (semihosting_stdout_head + amount) % SEMIHOSTING_STDOUT_BUFFER_SIZE;
+		semihosting_stdout_used += amount;
+		offset += amount;
+	}
+	return (int32_t)count;
+}
+
 /* Interface to host system calls */
 static int32_t semihosting_remote_read(
 	target_s *const target, const int32_t fd, const target_addr_t buf_taddr, const uint32_t count)
 {
 #if PC_HOSTED == 1
 	if ((target->stdout_redirected && fd == STDIN_FILENO) || fd > STDERR_FILENO) {
-		uint8_t *const buf = malloc(count);
+		/* Stream the file through to the target a chunk at a time rather than staging the whole request */
+		const size_t chunk_size = MIN(count, SEMIHOSTING_IO_CHUNK_SIZE);
+		uint8_t *const buf = malloc(chunk_size);
 		if (buf == NULL)
 			return -1;
-		const ssize_t result = read(fd, buf, count);
-		target->tc->gdb_errno = semihosting_errno();
-		target_mem_write(target, buf_taddr, buf, count);
+		uint32_t offset = 0;
+		while (offset < count) {
+			const size_t amount = MIN(count - offset, chunk_size);
+			const ssize_t result = read(fd, buf, amount);
+			target->tc->gdb_errno = semihosting_errno();
+			if (result <= 0) {
+				free(buf);
+				return result < 0 && !offset ? -1 : (int32_t)offset;
+			}
+			if (target_mem_write(target, buf_taddr + offset, buf, result)) {
+				free(buf);
+				return -1;
+			}
+			offset += result;
+			/* A short read means we've hit the end of the file or no more input is ready */
+			if ((size_t)result < amount)
+				break;
+		}
 		free(buf);
-		if (target_check_error(target))
-			return -1;
-		return result;
+		return (int32_t)offset;
 	}
 #endif
 	gdb_putpacket_f("Fread,%08X,%08" PRIX32 ",%08" PRIX32, (unsigned)fd, buf_taddr, count);
@@ -218,38 +346,50 @@ static int32_t semihosting_remote_write(
 {
 #if PC_HOSTED == 1
 	if (fd > STDERR_FILENO) {
-		uint8_t *const buf = malloc(count);
+		const size_t chunk_size = MIN(count, SEMIHOSTING_IO_CHUNK_SIZE);
+		uint8_t *const buf = malloc(chunk_size);
 		if (buf == NULL)
 			return -1;
-		target_mem_read(target, buf, buf_taddr, count);
-		if (target_check_error(target)) {
-			free(buf);
-			return -1;
+		uint32_t offset = 0;
+		while (offset < count) {
+			const size_t amount = MIN(count - offset, chunk_size);
+			if (target_mem_read(target, buf, buf_taddr + offset, amount)) {
+				free(buf);
+				return -1;
+			}
+			const ssize_t result = write(fd, buf, amount);
+			target->tc->gdb_errno = semihosting_errno();
+			if (result <= 0) {
+				free(buf);
+				return result < 0 && !offset ? -1 : (int32_t)offset;
+			}
+			offset += result;
+			if ((size_t)result < amount)
+				break;
 		}
-		const int32_t result = write(fd, buf, count);
-		target->tc->gdb_errno = semihosting_errno();
 		free(buf);
-		return result;
+		return (int32_t)offset;
 	}
 #endif
 
+	if (semihosting_stdout_is_buffered(target, fd))
+		return semihosting_stdout_write(target, buf_taddr, count);
+
+#if PC_HOSTED == 1
 	if (target->stdout_redirected && (fd == STDOUT_FILENO || fd == STDERR_FILENO)) {
 		uint8_t buffer[STDOUT_READ_BUF_SIZE];
 		for (size_t offset = 0; offset < count; offset += STDOUT_READ_BUF_SIZE) {
 			const size_t amount = MIN(count - offset, STDOUT_READ_BUF_SIZE);
-			target_mem_read(target, buffer, buf_taddr, amount);
-#if PC_HOSTED == 0
-			debug_serial_send_stdout(buffer, amount);
-#else
+			target_mem_read(target, buffer, buf_taddr + offset, amount);
 			const ssize_t result = write(fd, buffer, amount);
 			if (result == -1) {
 				target->tc->gdb_errno = semihosting_errno();
 				return offset;
 			}
-#endif
 		}
 		return (int32_t)count;
 	}
+#endif
 
 	gdb_putpacket_f("Fwrite,%08X,%08" PRIX32 ",%08" PRIX32, (unsigned)fd, buf_taddr, count);
 	return semihosting_get_gdb_response(target->tc);
@@ -487,13 +627,31 @@ int32_t semihosting_writec(target_s *const target, const semihosting_s *const re
 int32_t semihosting_write0(target_s *const target, const semihosting_s *const request)
 {
 	const target_addr_t str_begin_taddr = request->r1;
-	target_addr_t str_end_taddr;
-	for (str_end_taddr = str_begin_taddr; target_mem_read8(target, str_end_taddr) != 0; ++str_end_taddr) {
-		if (target_check_error(target))
+	const bool buffered = semihosting_stdout_is_buffered(target, STDOUT_FILENO);
+	/*
+	 * Scan for the terminator a block at a time. Blocks are aligned so a read never runs off the
+	 * end of a memory region the string itself does not also reach into.
+	 */
+	uint8_t block[STDOUT_READ_BUF_SIZE];
+	target_addr_t str_end_taddr = str_begin_taddr;
+	while (true) {
+		const size_t amount = STDOUT_READ_BUF_SIZE - (str_end_taddr & (STDOUT_READ_BUF_SIZE - 1U));
+		if (target_mem_read(target, block, str_end_taddr, amount))
+			return -1;
+		const uint8_t *const terminator = memchr(block, 0, amount);
+		const size_t length = terminator ? (size_t)(terminator - block) : amount;
+		/* In buffered mode we already have the string data, so there's no need to read it back again later */
+		if (buffered)
+			semihosting_stdout_push(target, block, length);
+		str_end_taddr += length;
+		if (terminator)
 			break;
 	}
+	if (buffered)
+		return 0;
+
 	const int32_t len = str_end_taddr - str_begin_taddr;
-	if (len >= 0) {
+	if (len > 0) {
 		const int32_t result = semihosting_remote_write(target, STDOUT_FILENO, str_begin_taddr, len);
 		if (result != len)
 			return -1;
@@ -890,5 +1048,8 @@ int32_t semihosting_request(target_s *const target, const uint32_t syscall, cons
 	if (syscall != SEMIHOSTING_SYS_ERRNO)
 		target->tc->gdb_errno = TARGET_SUCCESS;
 #endif
+	/* Make sure any buffered console output goes out ahead of whatever this request does */
+	if (syscall != SEMIHOSTING_SYS_WRITE && syscall != SEMIHOSTING_SYS_WRITEC && syscall != SEMIHOSTING_SYS_WRITE0)
+		semihosting_stdout_flush(true);
 	return semihosting_handle_request(target, &request, syscall);
 }
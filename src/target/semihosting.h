@@ -29,5 +29,6 @@ extern uint32_t semihosting_wallclock_epoch;
 
 int32_t semihosting_request(target_s *target, uint32_t syscall, uint32_t r1);
 int semihosting_reply(target_controller_s *tc, char *packet, int len);
+void semihosting_stdout_flush(bool wait);
 
 #endif /* TARGET_SEMIHOSTING_H */
@@ -54,6 +54,18 @@
 
 #define STDOUT_READ_BUF_SIZE 64U
 
+#if PC_HOSTED == 1
+#define SEMIHOSTING_STDOUT_BUFFER_SIZE 4096U
+#else
+#define SEMIHOSTING_STDOUT_BUFFER_SIZE 1024U
+#endif
+/* Largest single block moved between the target and a host file by BMDA in one go */
+#define SEMIHOSTING_IO_CHUNK_SIZE 65536U
+/* Largest amount of output sent to the GDB console in a single 'O' packet */
+#define SEMIHOSTING_CONSOLE_CHUNK_SIZE 128U
+/* How long to wait for the output sink to accept more data before giving up on it, in ms */
+#define SEMIHOSTING_STDOUT_FLUSH_TIMEOUT 250U
+
 typedef struct semihosting {
 	uint32_t r1;
 	uint32_t params[4U];
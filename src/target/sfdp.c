@@ -65,6 +65,13 @@ static inline size_t sfdp_memory_density_to_capacity_bits(const uint8_t *const d
 		return SFDP_DENSITY_VALUE(density) + 1U;
 }
 
+static void sfdp_fast_read(spi_fast_read_s *const fast_read, const timings_and_opcode_s *const timings)
+{
+	fast_read->opcode = timings->opcode;
+	fast_read->dummy_cycles = SFDP_FAST_READ_DUMMY_CYCLES(timings);
+	fast_read->mode_cycles = SFDP_FAST_READ_MODE_CYCLES(timings);
+}
+
 static spi_parameters_s sfdp_read_basic_parameter_table(target_s *const target,
 	const sfdp_parameter_table_header_s *const header, const uint32_t address, const size_t length,
 	const spi_read_func spi_read)
@@ -76,14 +83,38 @@ static spi_parameters_s sfdp_read_basic_parameter_table(target_s *const target,
 
 	spi_parameters_s result = {0};
 	result.capacity = sfdp_memory_density_to_capacity_bits(parameter_table.memory_density) >> 3U;
+	size_t erase_types = 0;
 	for (size_t i = 0; i < SFDP_ERASE_TYPES; ++i) {
 		erase_parameters_s *erase_type = &parameter_table.erase_types[i];
-		if (erase_type->opcode == parameter_table.sector_erase_opcode) {
+		/* An exponent of 0 marks the erase type as unused */
+		if (!erase_type->erase_size_exponent)
+			continue;
+		if (erase_type->opcode == parameter_table.sector_erase_opcode && !result.sector_size) {
 			result.sector_erase_opcode = erase_type->opcode;
 			result.sector_size = SFDP_ERASE_SIZE(erase_type);
-			break;
 		}
+		/* Insert the erase type into the list keeping it sorted largest first */
+		const spi_erase_type_s entry = {SFDP_ERASE_SIZE(erase_type), erase_type->opcode};
+		size_t slot = erase_types++;
+		for (; slot && result.erase_types[slot - 1U].size < entry.size; --slot)
+			result.erase_types[slot] = result.erase_types[slot - 1U];
+		result.erase_types[slot] = entry;
 	}
+	/* Fast read (0Bh) isn't described by SFDP but is supported by every device that has SFDP */
+	result.fast_reads[SPI_READ_MODE_1_1_1] = (spi_fast_read_s){0x0bU, 8U, 0U};
+	if (parameter_table.value2 & SFDP_FAST_READ_1_1_2)
+		sfdp_fast_read(&result.fast_reads[SPI_READ_MODE_1_1_2], &parameter_table.fast_dual_output);
+	if (parameter_table.value2 & SFDP_FAST_READ_1_2_2)
+		sfdp_fast_read(&result.fast_reads[SPI_READ_MODE_1_2_2], &parameter_table.fast_dual_io);
+	if (parameter_table.value2 & SFDP_FAST_READ_1_1_4)
+		sfdp_fast_read(&result.fast_reads[SPI_READ_MODE_1_1_4], &parameter_table.fast_quad_output);
+	if (parameter_table.value2 & SFDP_FAST_READ_1_4_4)
+		sfdp_fast_read(&result.fast_reads[SPI_READ_MODE_1_4_4], &parameter_table.fast_quad_io);
+	if (table_length >= SFDP_QUAD_ENABLE_MIN_LENGTH)
+		result.quad_enable_requirement = SFDP_QUAD_ENABLE_REQUIREMENT(parameter_table);
+	else
+		result.quad_enable_requirement = SPI_FLASH_QUAD_ENABLE_UNKNOWN;
+
 	// The timing and page size DWORD was added in JESD216A. It is marked as
 	// version 1.5.
 	if (header->version_major > 1 || (header->version_major == 1 && header->version_minor >= 5))
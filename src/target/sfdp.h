@@ -46,11 +46,44 @@ typedef struct spi_flash_id {
 	uint8_t capacity;
 } spi_flash_id_s;
 
+#define SPI_FLASH_ERASE_TYPES 4U
+
+typedef struct spi_erase_type {
+	uint32_t size;
+	uint8_t opcode;
+} spi_erase_type_s;
+
+/* Read modes, named by the number of lines used for the command, address and data phases, narrowest first */
+typedef enum spi_read_mode {
+	SPI_READ_MODE_1_1_1,
+	SPI_READ_MODE_1_1_2,
+	SPI_READ_MODE_1_2_2,
+	SPI_READ_MODE_1_1_4,
+	SPI_READ_MODE_1_4_4,
+	SPI_READ_MODE_COUNT,
+} spi_read_mode_e;
+
+#define SPI_READ_MODE_MASK(mode) (1U << (mode))
+
+typedef struct spi_fast_read {
+	uint8_t opcode; /* 0 if the mode is not supported */
+	uint8_t dummy_cycles;
+	uint8_t mode_cycles;
+} spi_fast_read_s;
+
+/* Value for the quad enable requirement when the SFDP tables are too old to tell us it */
+#define SPI_FLASH_QUAD_ENABLE_UNKNOWN 0xffU
+
 typedef struct spi_parameters {
 	uint32_t page_size;
 	uint32_t sector_size;
 	size_t capacity;
 	uint8_t sector_erase_opcode;
+	/* Erase types the device supports, largest first, with unused entries having a size of 0 */
+	spi_erase_type_s erase_types[SPI_FLASH_ERASE_TYPES];
+	spi_fast_read_s fast_reads[SPI_READ_MODE_COUNT];
+	/* JESD216 quad enable requirement (QER) type */
+	uint8_t quad_enable_requirement;
 } spi_parameters_s;
 
 typedef void (*spi_read_func)(target_s *target, uint16_t command, target_addr_t address, void *buffer, size_t length);
@@ -52,6 +52,19 @@
 #define SFDP_DENSITY_VALUE(density) \
 	((((density)[3] & 0x7fU) << 24U) | ((density)[2] << 16U) | ((density)[1] << 8U) | (density)[0])
 
+#define SFDP_FAST_READ_1_1_2 (1U << 0U)
+#define SFDP_FAST_READ_1_2_2 (1U << 4U)
+#define SFDP_FAST_READ_1_4_4 (1U << 5U)
+#define SFDP_FAST_READ_1_1_4 (1U << 6U)
+
+#define SFDP_FAST_READ_DUMMY_CYCLES(timings) ((timings)->timings & 0x1fU)
+#define SFDP_FAST_READ_MODE_CYCLES(timings)  ((timings)->timings >> 5U)
+
+/* The quad enable requirement field was added in JESD216A in DWORD 15 */
+#define SFDP_QUAD_ENABLE_MIN_LENGTH 60U
+#define SFDP_QUAD_ENABLE_REQUIREMENT(parameter_table) \
+	(((parameter_table).dual_and_quad_mode[2] >> 4U) & 0x07U)
+
 #define SFDP_ERASE_TYPES            4U
 #define SFDP_ERASE_SIZE(erase_type) (1U << ((erase_type)->erase_size_exponent))
 #define SFDP_PAGE_SIZE(parameter_table) \
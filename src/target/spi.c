@@ -121,8 +121,16 @@ spi_flash_s *bmp_spi_add_flash(target_s *const target, const target_addr_t begin
 		spi_parameters.sector_size = 4096U;
 		spi_parameters.capacity = length;
 		spi_parameters.sector_erase_opcode = SPI_FLASH_OPCODE_SECTOR_ERASE;
+		memset(spi_parameters.erase_types, 0, sizeof(spi_parameters.erase_types));
+		memset(spi_parameters.fast_reads, 0, sizeof(spi_parameters.fast_reads));
+		spi_parameters.quad_enable_requirement = SPI_FLASH_QUAD_ENABLE_UNKNOWN;
 		DEBUG_WARN("SFDP read failed. Using best guess.\n");
 	}
+	/* Make sure the sector erase is always available to the erase planner */
+	if (!spi_parameters.erase_types[0].size) {
+		spi_parameters.erase_types[0].size = spi_parameters.sector_size;
+		spi_parameters.erase_types[0].opcode = spi_parameters.sector_erase_opcode;
+	}
 	DEBUG_INFO("Flash size: %" PRIu32 "MiB\n", (uint32_t)spi_parameters.capacity / (1024U * 1024U));
 
 	target_flash_s *const flash = &spi_flash->flash;
@@ -132,16 +140,72 @@ spi_flash_s *bmp_spi_add_flash(target_s *const target, const target_addr_t begin
 	flash->write = bmp_spi_flash_write;
 	flash->erase = bmp_spi_flash_erase;
 	flash->erased = 0xffU;
+	flash->range_erase = true;
 	target_add_flash(target, flash);
 
 	spi_flash->page_size = spi_parameters.page_size;
 	spi_flash->sector_erase_opcode = spi_parameters.sector_erase_opcode;
+	memcpy(spi_flash->erase_types, spi_parameters.erase_types, sizeof(spi_flash->erase_types));
+	memcpy(spi_flash->fast_reads, spi_parameters.fast_reads, sizeof(spi_flash->fast_reads));
+	spi_flash->quad_enable_requirement = spi_parameters.quad_enable_requirement;
 	spi_flash->read = spi_read;
 	spi_flash->write = spi_write;
 	spi_flash->run_command = spi_run_command;
 	return spi_flash;
 }
 
+/* Check, without changing anything, whether the Flash currently has its quad I/O modes enabled */
+static bool bmp_spi_quad_enabled(target_s *const target, const spi_flash_s *const flash)
+{
+	uint8_t status = 0;
+	switch (flash->quad_enable_requirement) {
+	case 0U:
+		/* The device has no QE bit, so the quad modes are always available */
+		return true;
+	case 2U:
+		flash->read(target, SPI_FLASH_CMD_READ_STATUS, 0U, &status, sizeof(status));
+		return status & SPI_FLASH_STATUS_QE_SR1_BIT6;
+	case 3U:
+		flash->read(target, SPI_FLASH_CMD_READ_STATUS2_ALT, 0U, &status, sizeof(status));
+		return status & SPI_FLASH_STATUS_QE_SR2_BIT7;
+	case 4U:
+	case 5U:
+	case 6U:
+		flash->read(target, SPI_FLASH_CMD_READ_STATUS2, 0U, &status, sizeof(status));
+		return status & SPI_FLASH_STATUS_QE_SR2_BIT1;
+	default:
+		/* Type 1 devices have no reliable way to read the QE bit back, and for the rest we just don't know */
+		return false;
+	}
+}
+
+/*
+ * Pick the widest fast read mode out of those the controller allows (a mask built with SPI_READ_MODE_MASK())
+ * that the Flash both supports and has enabled. Modes that need mode bits driving are skipped.
+ * Returns SPI_READ_MODE_COUNT if nothing suitable was found, in which case a plain 03h read should be used.
+ */
+spi_read_mode_e bmp_spi_select_read_mode(
+	target_s *const target, const spi_flash_s *const flash, const uint8_t allowed_modes)
+{
+	bool quad_checked = false;
+	bool quad_enabled = false;
+	for (size_t mode = SPI_READ_MODE_COUNT; mode-- > 0U;) {
+		const spi_fast_read_s *const fast_read = &flash->fast_reads[mode];
+		if (!(allowed_modes & SPI_READ_MODE_MASK(mode)) || !fast_read->opcode || fast_read->mode_cycles)
+			continue;
+		if (mode >= SPI_READ_MODE_1_1_4) {
+			if (!quad_checked) {
+				quad_enabled = bmp_spi_quad_enabled(target, flash);
+				quad_checked = true;
+			}
+			if (!quad_enabled)
+				continue;
+		}
+		return (spi_read_mode_e)mode;
+	}
+	return SPI_READ_MODE_COUNT;
+}
+
 /* Note: These routines assume that the first Flash registered on the target is a SPI Flash device */
 bool bmp_spi_mass_erase(target_s *const target)
 {
@@ -167,19 +231,52 @@ bool bmp_spi_mass_erase(target_s *const target)
 	return target->exit_flash_mode(target);
 }
 
+/*
+ * Pick the largest erase the device supports that starts at offset and fits in what's left to erase.
+ * As erase sizes are all powers of two, taking the largest that fits at each step gives the fewest commands.
+ */
+static const spi_erase_type_s *bmp_spi_plan_erase(
+	const spi_flash_s *const spi_flash, const target_addr_t offset, const size_t remaining)
+{
+	for (size_t i = 0; i < SPI_FLASH_ERASE_TYPES; ++i) {
+		const spi_erase_type_s *const erase_type = &spi_flash->erase_types[i];
+		if (erase_type->size && !(offset & (erase_type->size - 1U)) && erase_type->size <= remaining)
+			return erase_type;
+	}
+	return NULL;
+}
+
 static bool bmp_spi_flash_erase(target_flash_s *const flash, const target_addr_t addr, const size_t length)
 {
-	(void)length;
 	target_s *const target = flash->t;
 	const spi_flash_s *const spi_flash = (spi_flash_s *)flash;
-	spi_flash->run_command(target, SPI_FLASH_CMD_WRITE_ENABLE, 0U);
-	if (!(bmp_spi_read_status(target, spi_flash) & SPI_FLASH_STATUS_WRITE_ENABLED))
-		return false;
+	platform_timeout_s timeout;
+	platform_timeout_set(&timeout, 500);
 
-	spi_flash->run_command(
-		target, SPI_FLASH_CMD_SECTOR_ERASE | SPI_FLASH_OPCODE(spi_flash->sector_erase_opcode), addr - flash->start);
-	while (bmp_spi_read_status(target, spi_flash) & SPI_FLASH_STATUS_BUSY)
-		continue;
+	/* If the whole device is being erased, a chip erase is by far the quickest way to do it */
+	const bool chip_erase = addr == flash->start && length >= flash->length;
+	target_addr_t offset = addr - flash->start;
+	const target_addr_t end = offset + length;
+	while (offset < end) {
+		uint16_t command = SPI_FLASH_CMD_CHIP_ERASE;
+		size_t amount = length;
+		if (!chip_erase) {
+			const spi_erase_type_s *const erase_type = bmp_spi_plan_erase(spi_flash, offset, end - offset);
+			if (!erase_type)
+				return false;
+			command = SPI_FLASH_CMD_SECTOR_ERASE | SPI_FLASH_OPCODE(erase_type->opcode);
+			amount = erase_type->size;
+		}
+
+		spi_flash->run_command(target, SPI_FLASH_CMD_WRITE_ENABLE, 0U);
+		if (!(bmp_spi_read_status(target, spi_flash) & SPI_FLASH_STATUS_WRITE_ENABLED))
+			return false;
+
+		spi_flash->run_command(target, command, offset);
+		while (bmp_spi_read_status(target, spi_flash) & SPI_FLASH_STATUS_BUSY)
+			target_print_progress(&timeout);
+		offset += amount;
+	}
 	return true;
 }
 
@@ -39,6 +39,7 @@
 #include "general.h"
 #include "target_internal.h"
 #include "spi_types.h"
+#include "sfdp.h"
 
 #define SPI_FLASH_OPCODE_MASK      0x00ffU
 #define SPI_FLASH_OPCODE(x)        ((x)&SPI_FLASH_OPCODE_MASK)
@@ -61,6 +62,10 @@
 #define SPI_FLASH_CMD_CHIP_ERASE   (SPI_FLASH_OPCODE_ONLY | SPI_FLASH_DUMMY_LEN(0) | SPI_FLASH_OPCODE(0x60U))
 #define SPI_FLASH_CMD_READ_STATUS \
 	(SPI_FLASH_OPCODE_ONLY | SPI_FLASH_DATA_IN | SPI_FLASH_DUMMY_LEN(0) | SPI_FLASH_OPCODE(0x05U))
+#define SPI_FLASH_CMD_READ_STATUS2 \
+	(SPI_FLASH_OPCODE_ONLY | SPI_FLASH_DATA_IN | SPI_FLASH_DUMMY_LEN(0) | SPI_FLASH_OPCODE(0x35U))
+#define SPI_FLASH_CMD_READ_STATUS2_ALT \
+	(SPI_FLASH_OPCODE_ONLY | SPI_FLASH_DATA_IN | SPI_FLASH_DUMMY_LEN(0) | SPI_FLASH_OPCODE(0x3fU))
 #define SPI_FLASH_CMD_READ_JEDEC_ID \
 	(SPI_FLASH_OPCODE_ONLY | SPI_FLASH_DATA_IN | SPI_FLASH_DUMMY_LEN(0) | SPI_FLASH_OPCODE(0x9fU))
 #define SPI_FLASH_CMD_READ_SFDP \
@@ -69,6 +74,9 @@
 
 #define SPI_FLASH_STATUS_BUSY          0x01U
 #define SPI_FLASH_STATUS_WRITE_ENABLED 0x02U
+#define SPI_FLASH_STATUS_QE_SR1_BIT6   0x40U
+#define SPI_FLASH_STATUS_QE_SR2_BIT1   0x02U
+#define SPI_FLASH_STATUS_QE_SR2_BIT7   0x80U
 
 typedef void (*spi_read_func)(target_s *target, uint16_t command, target_addr_t address, void *buffer, size_t length);
 typedef void (*spi_write_func)(
@@ -79,6 +87,9 @@ typedef struct spi_flash {
 	target_flash_s flash;
 	uint32_t page_size;
 	uint8_t sector_erase_opcode;
+	spi_erase_type_s erase_types[SPI_FLASH_ERASE_TYPES];
+	spi_fast_read_s fast_reads[SPI_READ_MODE_COUNT];
+	uint8_t quad_enable_requirement;
 
 	spi_read_func read;
 	spi_write_func write;
@@ -93,5 +104,6 @@ void bmp_spi_run_command(spi_bus_e bus, uint8_t device, uint16_t command, target
 spi_flash_s *bmp_spi_add_flash(target_s *target, target_addr_t begin, size_t length, spi_read_func spi_read,
 	spi_write_func spi_write, spi_run_command_func spi_run_command);
 bool bmp_spi_mass_erase(target_s *target);
+spi_read_mode_e bmp_spi_select_read_mode(target_s *target, const spi_flash_s *flash, uint8_t allowed_modes);
 
 #endif /* TARGET_SPI_H */
@@ -27,6 +27,23 @@
 #include <unistd.h>
 #include <assert.h>
 
+#if PC_HOSTED == 1
+#include "wire_trace.h"
+
+/* Record high-level target operations in BMDA's wire trace so probe round trips can be attributed to them */
+#define TARGET_TRACE_BEGIN()  \
+	wire_trace_mark_s mark; \
+	wire_trace_begin(&mark)
+#define TARGET_TRACE_END(event, address, length) wire_trace_end(&mark, event, address, length)
+#else
+#define TARGET_TRACE_BEGIN() \
+	do {                     \
+	} while (0)
+#define TARGET_TRACE_END(event, address, length) \
+	do {                                         \
+	} while (0)
+#endif
+
 /* Fixup for when _FILE_OFFSET_BITS == 64 as unistd.h screws this up for us */
 #if defined(lseek)
 #undef lseek
@@ -36,17 +53,54 @@ target_s *target_list = NULL;
 
 #define FLASH_WRITE_BUFFER_CEILING 1024U
 
+/*
+ * The read cache holds a handful of line-sized chunks of RAM and Flash, and the register block for drivers
+ * that don't keep their own, for as long as the target stays halted. Everything is tagged with the halt epoch
+ * it was read in and flushing just starts a new epoch, so resuming, writing, Flash operations and monitor
+ * commands are all cheap to handle. Register writes only drop the cached register block.
+ */
+#define TARGET_READ_CACHE_LINE_SIZE 64U
+#if PC_HOSTED == 1
+#define TARGET_READ_CACHE_LINES 16U
+#else
+#define TARGET_READ_CACHE_LINES 4U
+#endif
+/* Reads bigger than this are unlikely to be repeated, so go straight to the target rather than thrash the cache */
+#define TARGET_READ_CACHE_MAX_READ (TARGET_READ_CACHE_LINE_SIZE * TARGET_READ_CACHE_LINES / 2U)
+
+typedef struct target_read_cache_line {
+	target_addr_t address;
+	uint32_t epoch;
+	uint8_t data[TARGET_READ_CACHE_LINE_SIZE];
+} target_read_cache_line_s;
+
+struct target_read_cache {
+	uint32_t epoch;
+	uint8_t next_victim;
+	target_read_cache_line_s lines[TARGET_READ_CACHE_LINES];
+	uint32_t regs_epoch;
+	size_t regs_size;
+	uint8_t regs[];
+};
+
 static bool target_cmd_mass_erase(target_s *target, int argc, const char **argv);
 static bool target_cmd_range_erase(target_s *target, int argc, const char **argv);
 static bool target_cmd_redirect_output(target_s *target, int argc, const char **argv);
+static bool target_cmd_flash_stats(target_s *target, int argc, const char **argv);
+static bool target_cmd_read_cache(target_s *target, int argc, const char **argv);
 
 const command_s target_cmd_list[] = {
 	{"erase_mass", target_cmd_mass_erase, "Erase whole device Flash"},
 	{"erase_range", target_cmd_range_erase, "Erase a range of memory on a device"},
-	{"redirect_stdout", target_cmd_redirect_output, "Redirect semihosting output to aux USB serial"},
+	{"redirect_stdout", target_cmd_redirect_output,
+		"Redirect semihosting output to aux USB serial or the GDB console: [enable|disable|console]"},
+	{"flash_stats", target_cmd_flash_stats, "Show Flash operation timing and link usage: [reset]"},
+	{"read_cache", target_cmd_read_cache, "Cache target reads while halted: [enable|disable]"},
 	{NULL, NULL, NULL},
 };
 
+target_link_stats_s target_link_stats;
+
 target_s *target_new(void)
 {
 	target_s *target = calloc(1, sizeof(*target));
@@ -64,6 +118,8 @@ target_s *target_new(void)
 		target_list = target;
 
 	target->target_storage = NULL;
+	/* The cache only pays for itself where every round trip to the probe is expensive */
+	target->read_cache_enabled = PC_HOSTED == 1;
 
 	target_add_commands(target, target_cmd_list, "Target");
 	return target;
@@ -120,6 +176,7 @@ void target_list_free(void)
 			target->commands = tc;
 		}
 		free(target->target_storage);
+		free(target->read_cache);
 		target_mem_map_free(target);
 		while (target->bw_list) {
 			void *next = target->bw_list->next;
@@ -177,6 +234,9 @@ target_s *target_attach(target_s *target, target_controller_s *controller)
 	}
 
 	target->attached = true;
+	/* Attaching leaves the target halted, and anything cached from a previous session is stale */
+	target->halted = true;
+	target_read_cache_flush(target);
 	return target;
 }
 
@@ -246,6 +306,7 @@ bool target_mem_map(target_s *target, char *tmp, size_t len)
 
 void target_print_progress(platform_timeout_s *const timeout)
 {
+	++target_link_stats.busy_polls;
 	if (platform_timeout_is_expired(timeout)) {
 		gdb_out(".");
 		platform_timeout_set(timeout, 500);
@@ -255,10 +316,13 @@ void target_print_progress(platform_timeout_s *const timeout)
 /* Wrapper functions */
 void target_detach(target_s *target)
 {
+	(void)target_breakwatch_commit(target);
 	if (target->detach)
 		target->detach(target);
 	platform_target_clk_output_enable(false);
 	target->attached = false;
+	target->halted = false;
+	target_read_cache_flush(target);
 #if PC_HOSTED == 1
 	platform_buffer_flush();
 #endif
@@ -276,6 +340,126 @@ bool target_attached(target_s *target)
 	return target->attached;
 }
 
+/* Read cache functions */
+void target_read_cache_flush(target_s *const target)
+{
+	target_read_cache_s *const cache = target->read_cache;
+	if (!cache)
+		return;
+	/* Starting a new epoch invalidates everything, unless the counter wraps and old tags could match again */
+	if (++cache->epoch == 0U) {
+		for (size_t i = 0; i < TARGET_READ_CACHE_LINES; ++i)
+			cache->lines[i].epoch = 0U;
+		cache->regs_epoch = 0U;
+		cache->epoch = 1U;
+	}
+}
+
+/* Get the read cache if it can be used right now, allocating it on first use */
+static target_read_cache_s *target_read_cache(target_s *const target)
+{
+	if (!target->read_cache_enabled || !target->halted || target->flash_mode)
+		return NULL;
+	if (!target->read_cache) {
+		target_read_cache_s *const cache = calloc(1, sizeof(*cache) + target->regs_size);
+		if (!cache) { /* calloc failed: heap exhaustion */
+			DEBUG_ERROR("calloc: failed in %s\n", __func__);
+			return NULL;
+		}
+		/* Epoch 0 marks a line as empty, so start from 1 */
+		cache->epoch = 1U;
+		cache->regs_size = target->regs_size;
+		target->read_cache = cache;
+	}
+	return target->read_cache;
+}
+
+/* Only RAM and Flash are safe to cache, and only if each line the read touches lies entirely in one region */
+static bool target_read_cacheable(target_s *const target, const target_addr_t src, const size_t len)
+{
+	if (!len || len > TARGET_READ_CACHE_MAX_READ)
+		return false;
+	const target_addr_t begin = src & ~(TARGET_READ_CACHE_LINE_SIZE - 1U);
+	const target_addr_t end = (src + len + TARGET_READ_CACHE_LINE_SIZE - 1U) & ~(TARGET_READ_CACHE_LINE_SIZE - 1U);
+	/* Don't try to cache anything that runs off the top of the address space */
+	if (end <= begin)
+		return false;
+	for (const target_ram_s *ram = target->ram; ram; ram = ram->next) {
+		if (begin >= ram->start && end <= ram->start + ram->length)
+			return true;
+	}
+	for (const target_flash_s *flash = target->flash; flash; flash = flash->next) {
+		if (begin >= flash->start && end <= flash->start + flash->length)
+			return true;
+	}
+	return false;
+}
+
+static int target_mem_read_uncached(target_s *const target, void *const dest, const target_addr_t src, const size_t len)
+{
+	target_link_stats.bytes += len;
+	++target_link_stats.transactions;
+	/* Otherwise if the target defines a memory read function, call that instead and check for errors */
+	TARGET_TRACE_BEGIN();
+	if (target->mem_read)
+		target->mem_read(target, dest, src, len);
+	TARGET_TRACE_END(WIRE_TRACE_OP_MEM_READ, src, len);
+	return target_check_error(target);
+}
+
+static target_read_cache_line_s *target_read_cache_find(target_read_cache_s *const cache, const target_addr_t address)
+{
+	for (size_t i = 0; i < TARGET_READ_CACHE_LINES; ++i) {
+		if (cache->lines[i].epoch == cache->epoch && cache->lines[i].address == address)
+			return &cache->lines[i];
+	}
+	return NULL;
+}
+
+static int target_mem_read_cached(target_s *const target, target_read_cache_s *const cache, void *const dest,
+	const target_addr_t src, const size_t len)
+{
+	uint8_t *const data = (uint8_t *)dest;
+	const target_addr_t end = src + len;
+	/* Serve what's already cached, noting the span of lines that aren't */
+	target_addr_t miss_begin = 0U;
+	target_addr_t miss_end = 0U;
+	for (target_addr_t address = src & ~(TARGET_READ_CACHE_LINE_SIZE - 1U); address < end;
+		 address += TARGET_READ_CACHE_LINE_SIZE) {
+		const target_read_cache_line_s *const line = target_read_cache_find(cache, address);
+		if (!line) {
+			if (miss_begin == miss_end)
+				miss_begin = address;
+			miss_end = address + TARGET_READ_CACHE_LINE_SIZE;
+			continue;
+		}
+		const target_addr_t chunk_begin = MAX(src, address);
+		const target_addr_t chunk_end = MIN(end, address + TARGET_READ_CACHE_LINE_SIZE);
+		memcpy(data + (chunk_begin - src), line->data + (chunk_begin - address), chunk_end - chunk_begin);
+	}
+	if (miss_begin == miss_end)
+		return false;
+
+	/* Fetch every missing line in a single read, along with any cached ones that sit between them */
+	uint8_t buffer[TARGET_READ_CACHE_MAX_READ + TARGET_READ_CACHE_LINE_SIZE];
+	if (target_mem_read_uncached(target, buffer, miss_begin, miss_end - miss_begin))
+		return true;
+	const target_addr_t chunk_begin = MAX(src, miss_begin);
+	const target_addr_t chunk_end = MIN(end, miss_end);
+	memcpy(data + (chunk_begin - src), buffer + (chunk_begin - miss_begin), chunk_end - chunk_begin);
+	/* Then fill the lines that missed into the next slots round */
+	for (target_addr_t address = miss_begin; address < miss_end; address += TARGET_READ_CACHE_LINE_SIZE) {
+		if (target_read_cache_find(cache, address))
+			continue;
+		target_read_cache_line_s *const line = &cache->lines[cache->next_victim];
+		cache->next_victim = (cache->next_victim + 1U) % TARGET_READ_CACHE_LINES;
+		memcpy(line->data, buffer + (address - miss_begin), TARGET_READ_CACHE_LINE_SIZE);
+		line->address = address;
+		line->epoch = cache->epoch;
+	}
+	return false;
+}
+
 /* Memory access functions */
 int target_mem_read(target_s *const target, void *const dest, const target_addr_t src, const size_t len)
 {
@@ -287,10 +471,14 @@ int target_mem_read(target_s *const target, void *const dest, const target_addr_
 		memcpy(dest, target->tc->semihosting_buffer_ptr, amount);
 		return false;
 	}
-	/* Otherwise if the target defines a memory read function, call that instead and check for errors */
-	if (target->mem_read)
-		target->mem_read(target, dest, src, len);
-	return target_check_error(target);
+	/* If we're part way through a Flash session, make sure any memory-mapped Flash being read is readable */
+	if (target->flash_mode && !target_flash_map_for_read(target, src, len))
+		return true;
+	/* While the target is halted, serve repeat reads of RAM and Flash from the cache */
+	target_read_cache_s *const cache = target_read_cache(target);
+	if (cache && target_read_cacheable(target, src, len))
+		return target_mem_read_cached(target, cache, dest, src, len);
+	return target_mem_read_uncached(target, dest, src, len);
 }
 
 int target_mem_write(target_s *const target, const target_addr_t dest, const void *const src, const size_t len)
@@ -303,9 +491,14 @@ int target_mem_write(target_s *const target, const target_addr_t dest, const voi
 		memcpy(target->tc->semihosting_buffer_ptr, src, amount);
 		return false;
 	}
+	target_read_cache_flush(target);
+	target_link_stats.bytes += len;
+	++target_link_stats.transactions;
 	/* Otherwise if the target defines a memory write function, call that instead and check for errors */
+	TARGET_TRACE_BEGIN();
 	if (target->mem_write)
 		target->mem_write(target, dest, src, len);
+	TARGET_TRACE_END(WIRE_TRACE_OP_MEM_WRITE, dest, len);
 	return target_check_error(target);
 }
 
@@ -326,8 +519,16 @@ ssize_t target_reg_read(target_s *t, uint32_t reg, void *data, size_t max)
 	return 0;
 }
 
+/* Drop the cached register block, leaving any cached memory alone */
+static void target_read_cache_regs_flush(target_s *const target)
+{
+	if (target->read_cache)
+		target->read_cache->regs_epoch = 0U;
+}
+
 ssize_t target_reg_write(target_s *t, uint32_t reg, const void *data, size_t size)
 {
+	target_read_cache_regs_flush(t);
 	if (t->reg_write)
 		return t->reg_write(t, reg, data, size);
 	return 0;
@@ -335,16 +536,30 @@ ssize_t target_reg_write(target_s *t, uint32_t reg, const void *data, size_t siz
 
 void target_regs_read(target_s *t, void *data)
 {
+	target_read_cache_s *const cache = t->driver_caches_regs ? NULL : target_read_cache(t);
+	/* The cache is sized from the register block at the time, so check it still matches */
+	const bool cacheable = cache && cache->regs_size == t->regs_size;
+	if (cacheable && cache->regs_epoch == cache->epoch) {
+		memcpy(data, cache->regs, t->regs_size);
+		return;
+	}
+	TARGET_TRACE_BEGIN();
 	if (t->regs_read)
 		t->regs_read(t, data);
 	else {
 		for (size_t x = 0, i = 0; x < t->regs_size;)
 			x += target_reg_read(t, i++, (uint8_t *)data + x, t->regs_size - x);
 	}
+	TARGET_TRACE_END(WIRE_TRACE_OP_REGS_READ, 0U, t->regs_size);
+	if (cacheable) {
+		memcpy(cache->regs, data, t->regs_size);
+		cache->regs_epoch = cache->epoch;
+	}
 }
 
 void target_regs_write(target_s *t, const void *data)
 {
+	target_read_cache_regs_flush(t);
 	if (t->regs_write)
 		t->regs_write(t, data);
 	else {
@@ -356,6 +571,9 @@ void target_regs_write(target_s *t, const void *data)
 /* Halt/resume functions */
 void target_reset(target_s *t)
 {
+	/* Whether the target comes out of reset halted is up to it, so wait for it to say */
+	t->halted = false;
+	target_read_cache_flush(t);
 	if (t->reset)
 		t->reset(t);
 }
@@ -368,14 +586,26 @@ void target_halt_request(target_s *t)
 
 target_halt_reason_e target_halt_poll(target_s *t, target_addr_t *watch)
 {
-	if (t->halt_poll)
-		return t->halt_poll(t, watch);
+	if (t->halt_poll) {
+		TARGET_TRACE_BEGIN();
+		const target_halt_reason_e reason = t->halt_poll(t, watch);
+		TARGET_TRACE_END(WIRE_TRACE_OP_HALT_POLL, 0U, 0U);
+		/* A fresh halt starts a new epoch for the read cache */
+		if (reason != TARGET_HALT_RUNNING && reason != TARGET_HALT_ERROR && !t->halted) {
+			t->halted = true;
+			target_read_cache_flush(t);
+		}
+		return reason;
+	}
 	/* XXX: Is this actually the desired fallback behaviour? */
 	return TARGET_HALT_RUNNING;
 }
 
 void target_halt_resume(target_s *t, bool step)
 {
+	t->halted = false;
+	target_read_cache_flush(t);
+	(void)target_breakwatch_commit(t);
 	if (t->halt_resume)
 		t->halt_resume(t, step);
 }
@@ -405,8 +635,57 @@ void target_set_heapinfo(
 }
 
 /* Break-/watchpoint functions */
+static void target_breakwatch_unlink(target_s *const t, breakwatch_s *const bw)
+{
+	breakwatch_s **link = &t->bw_list;
+	while (*link != bw)
+		link = &(*link)->next;
+	*link = bw->next;
+	free(bw);
+}
+
+/*
+ * GDB removes and reinserts every breakpoint and watchpoint around each stop and step. To avoid rewriting the
+ * comparators each time, clearing a breakwatch only marks it as pending, and the hardware is brought in line
+ * with what GDB last asked for when the target is next resumed or detached. Setting a breakwatch that's still
+ * pending clear then just revives it. Returns true if any breakwatches were cleared.
+ */
+bool target_breakwatch_commit(target_s *const t)
+{
+	bool cleared = false;
+	breakwatch_s *bw = t->bw_list;
+	while (bw) {
+		breakwatch_s *const next = bw->next;
+		if (bw->clear_pending) {
+			if (t->breakwatch_clear(t, bw) != 0)
+				DEBUG_WARN("Failed to clear breakwatch at 0x%08" PRIx32 "\n", bw->addr);
+			target_breakwatch_unlink(t, bw);
+			cleared = true;
+		}
+		bw = next;
+	}
+	return cleared;
+}
+
+static breakwatch_s *target_breakwatch_find(
+	target_s *const t, const target_breakwatch_e type, const target_addr_t addr, const size_t len, const bool pending)
+{
+	for (breakwatch_s *bw = t->bw_list; bw; bw = bw->next) {
+		if (bw->type == type && bw->addr == addr && bw->size == len && bw->clear_pending == pending)
+			return bw;
+	}
+	return NULL;
+}
+
 int target_breakwatch_set(target_s *t, target_breakwatch_e type, target_addr_t addr, size_t len)
 {
+	/* If GDB is putting back a breakwatch it just cleared, the hardware's still set up for it */
+	breakwatch_s *const pending = target_breakwatch_find(t, type, addr, len, true);
+	if (pending) {
+		pending->clear_pending = false;
+		return 0;
+	}
+
 	breakwatch_s bw = {
 		.type = type,
 		.addr = addr,
@@ -414,8 +693,12 @@ int target_breakwatch_set(target_s *t, target_breakwatch_e type, target_addr_t a
 	};
 	int ret = 1;
 
-	if (t->breakwatch_set)
+	if (t->breakwatch_set) {
 		ret = t->breakwatch_set(t, &bw);
+		/* If that failed, it may be for lack of comparators still held by pending clears, so free those up */
+		if (ret != 0 && target_breakwatch_commit(t))
+			ret = t->breakwatch_set(t, &bw);
+	}
 
 	if (ret == 0) {
 		/* Success, make a heap copy */
@@ -436,27 +719,23 @@ int target_breakwatch_set(target_s *t, target_breakwatch_e type, target_addr_t a
 
 int target_breakwatch_clear(target_s *t, target_breakwatch_e type, target_addr_t addr, size_t len)
 {
-	breakwatch_s *bwp = NULL, *bw;
-	for (bw = t->bw_list; bw; bwp = bw, bw = bw->next) {
-		if (bw->type == type && bw->addr == addr && bw->size == len)
-			break;
-	}
-
+	breakwatch_s *const bw = target_breakwatch_find(t, type, addr, len, false);
 	if (bw == NULL)
 		return -1;
-
-	int ret = 1;
-	if (t->breakwatch_clear)
-		ret = t->breakwatch_clear(t, bw);
-
-	if (ret == 0) {
-		if (bwp == NULL)
-			t->bw_list = bw->next;
-		else
-			bwp->next = bw->next;
-		free(bw);
+	if (!t->breakwatch_clear)
+		return 1;
+	/*
+	 * Software breakpoints have to go straight away as GDB expects to read back the original code once
+	 * it has removed them. Anything else is left till the target resumes, in case GDB puts it straight back
+	 */
+	if (bw->type == TARGET_BREAK_SOFT) {
+		const int ret = t->breakwatch_clear(t, bw);
+		if (ret == 0)
+			target_breakwatch_unlink(t, bw);
+		return ret;
 	}
-	return ret;
+	bw->clear_pending = true;
+	return 0;
 }
 
 /* Target-specific commands */
@@ -491,12 +770,42 @@ static bool target_cmd_range_erase(target_s *const t, const int argc, const char
 static bool target_cmd_redirect_output(target_s *target, int argc, const char **argv)
 {
 	if (argc == 1) {
-		gdb_outf("Semihosting stdout redirection: %s\n", target->stdout_redirected ? "enabled" : "disabled");
+		gdb_outf("Semihosting stdout redirection: %s\n",
+			target->stdout_redirected ? (target->stdout_console ? "GDB console" : "enabled") : "disabled");
+		return true;
+	}
+	const size_t value_len = strlen(argv[1]);
+	if (value_len && !strncmp(argv[1], "console", value_len)) {
+		target->stdout_redirected = true;
+		target->stdout_console = true;
 		return true;
 	}
+	target->stdout_console = false;
 	return parse_enable_or_disable(argv[1], &target->stdout_redirected);
 }
 
+static bool target_cmd_flash_stats(target_s *target, int argc, const char **argv)
+{
+	if (argc == 1) {
+		target_flash_stats_print(target);
+		return true;
+	}
+	if (strcmp(argv[1], "reset") != 0)
+		return false;
+	target_flash_stats_reset(target);
+	return true;
+}
+
+static bool target_cmd_read_cache(target_s *target, int argc, const char **argv)
+{
+	if (argc == 1) {
+		gdb_outf("Read cache: %s\n", target->read_cache_enabled ? "enabled" : "disabled");
+		return true;
+	}
+	target_read_cache_flush(target);
+	return parse_enable_or_disable(argv[1], &target->read_cache_enabled);
+}
+
 /* Accessor functions */
 size_t target_regs_size(target_s *t)
 {
@@ -538,6 +847,8 @@ unsigned int target_part_id(target_s *t)
 uint32_t target_mem_read32(target_s *t, uint32_t addr)
 {
 	uint32_t result = 0;
+	target_link_stats.bytes += sizeof(result);
+	++target_link_stats.transactions;
 	if (t->mem_read)
 		t->mem_read(t, &result, addr, sizeof(result));
 	return result;
@@ -545,6 +856,9 @@ uint32_t target_mem_read32(target_s *t, uint32_t addr)
 
 void target_mem_write32(target_s *t, uint32_t addr, uint32_t value)
 {
+	target_read_cache_flush(t);
+	target_link_stats.bytes += sizeof(value);
+	++target_link_stats.transactions;
 	if (t->mem_write)
 		t->mem_write(t, addr, &value, sizeof(value));
 }
@@ -552,6 +866,8 @@ void target_mem_write32(target_s *t, uint32_t addr, uint32_t value)
 uint16_t target_mem_read16(target_s *t, uint32_t addr)
 {
 	uint16_t result = 0;
+	target_link_stats.bytes += sizeof(result);
+	++target_link_stats.transactions;
 	if (t->mem_read)
 		t->mem_read(t, &result, addr, sizeof(result));
 	return result;
@@ -559,6 +875,9 @@ uint16_t target_mem_read16(target_s *t, uint32_t addr)
 
 void target_mem_write16(target_s *t, uint32_t addr, uint16_t value)
 {
+	target_read_cache_flush(t);
+	target_link_stats.bytes += sizeof(value);
+	++target_link_stats.transactions;
 	if (t->mem_write)
 		t->mem_write(t, addr, &value, sizeof(value));
 }
@@ -566,6 +885,8 @@ void target_mem_write16(target_s *t, uint32_t addr, uint16_t value)
 uint8_t target_mem_read8(target_s *t, uint32_t addr)
 {
 	uint8_t result = 0;
+	target_link_stats.bytes += sizeof(result);
+	++target_link_stats.transactions;
 	if (t->mem_read)
 		t->mem_read(t, &result, addr, sizeof(result));
 	return result;
@@ -573,6 +894,9 @@ uint8_t target_mem_read8(target_s *t, uint32_t addr)
 
 void target_mem_write8(target_s *t, uint32_t addr, uint8_t value)
 {
+	target_read_cache_flush(t);
+	target_link_stats.bytes += sizeof(value);
+	++target_link_stats.transactions;
 	if (t->mem_write)
 		t->mem_write(t, addr, &value, sizeof(value));
 }
@@ -590,8 +914,11 @@ int target_command(target_s *t, int argc, const char *argv[])
 {
 	for (const target_command_s *tc = t->commands; tc; tc = tc->next) {
 		for (const command_s *c = tc->cmds; c->cmd; c++) {
-			if (!strncmp(argv[0], c->cmd, strlen(argv[0])))
-				return c->handler(t, argc, argv) ? 0 : 1;
+			if (!strncmp(argv[0], c->cmd, strlen(argv[0]))) {
+				const bool result = c->handler(t, argc, argv);
+				target_read_cache_flush(t);
+				return result ? 0 : 1;
+			}
 		}
 	}
 	return -1;
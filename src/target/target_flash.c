@@ -53,6 +53,8 @@ static bool target_enter_flash_mode(target_s *target)
 {
 	if (target->flash_mode)
 		return true;
+	/* Flash routines may run stubs on the target, so removed breakwatches mustn't still be armed */
+	(void)target_breakwatch_commit(target);
 
 	bool result = true;
 	if (target->enter_flash_mode)
@@ -64,6 +66,7 @@ static bool target_enter_flash_mode(target_s *target)
 
 	if (result == true)
 		target->flash_mode = true;
+	target_read_cache_flush(target);
 	return result;
 }
 
@@ -80,11 +83,43 @@ static bool target_exit_flash_mode(target_s *target)
 		target_reset(target);
 
 	target->flash_mode = false;
+	target_read_cache_flush(target);
+	/* Leaving Flash mode puts any memory-mapped windows back as they were */
+	for (target_flash_s *flash = target->flash; flash; flash = flash->next)
+		flash->mapped = false;
 	return result;
 }
 
+typedef struct flash_stats_snapshot {
+	uint32_t start_time;
+	target_link_stats_s link;
+} flash_stats_snapshot_s;
+
+static void flash_stats_begin(flash_stats_snapshot_s *const snapshot)
+{
+	snapshot->start_time = platform_time_ms();
+	snapshot->link = target_link_stats;
+}
+
+/* Charge the time and link usage since the snapshot to the given Flash and operation step */
+static void flash_stats_end(
+	target_flash_s *const flash, const flash_stats_snapshot_s *const snapshot, uint32_t *const time)
+{
+	*time += platform_time_ms() - snapshot->start_time;
+	flash->stats.link.bytes += target_link_stats.bytes - snapshot->link.bytes;
+	flash->stats.link.transactions += target_link_stats.transactions - snapshot->link.transactions;
+	flash->stats.link.busy_polls += target_link_stats.busy_polls - snapshot->link.busy_polls;
+}
+
 static bool flash_prepare(target_flash_s *flash, flash_operation_e operation)
 {
+	/* If the Flash was switched over to its memory-mapped window for reading, switch it back to command mode */
+	if (flash->mapped) {
+		if (!flash->map(flash, false))
+			return false;
+		flash->mapped = false;
+	}
+
 	/* Check if we're already prepared for this operation */
 	if (flash->operation == operation)
 		return true;
@@ -98,8 +133,12 @@ static bool flash_prepare(target_flash_s *flash, flash_operation_e operation)
 	if (result) {
 		flash->operation = operation;
 		/* Prepare flash for operation, unless we failed to terminate the previous one */
-		if (flash->prepare)
+		if (flash->prepare) {
+			flash_stats_snapshot_s snapshot;
+			flash_stats_begin(&snapshot);
 			result = flash->prepare(flash);
+			flash_stats_end(flash, &snapshot, &flash->stats.prepare_time);
+		}
 
 		/* If the preparation step failed, revert back to the post-done state */
 		if (!result)
@@ -117,8 +156,12 @@ static bool flash_done(target_flash_s *flash)
 
 	bool result = true;
 	/* Terminate flash operation */
-	if (flash->done)
+	if (flash->done) {
+		flash_stats_snapshot_s snapshot;
+		flash_stats_begin(&snapshot);
 		result = flash->done(flash);
+		flash_stats_end(flash, &snapshot, &flash->stats.done_time);
+	}
 
 	/* Free the operation buffer */
 	if (flash->buf) {
@@ -155,12 +198,21 @@ bool target_flash_erase(target_s *target, target_addr_t addr, size_t len)
 		}
 
 		const target_addr_t local_start_addr = addr & ~(flash->blocksize - 1U);
-		const target_addr_t local_end_addr = local_start_addr + flash->blocksize;
+		target_addr_t local_end_addr = local_start_addr + flash->blocksize;
+		/* If the Flash can plan its own erase, hand it everything requested that falls within it in one go */
+		if (flash->range_erase) {
+			const target_addr_t range_end = MIN(addr + len, flash->start + flash->length);
+			local_end_addr = (range_end + flash->blocksize - 1U) & ~(flash->blocksize - 1U);
+		}
 
 		if (!flash_prepare(flash, FLASH_OPERATION_ERASE))
 			return false;
 
-		result &= flash->erase(flash, local_start_addr, flash->blocksize);
+		flash_stats_snapshot_s snapshot;
+		flash_stats_begin(&snapshot);
+		result &= flash->erase(flash, local_start_addr, local_end_addr - local_start_addr);
+		flash_stats_end(flash, &snapshot, &flash->stats.erase_time);
+		flash->stats.bytes_erased += local_end_addr - local_start_addr;
 		if (!result) {
 			DEBUG_ERROR("Erase failed at %" PRIx32 "\n", local_start_addr);
 			break;
@@ -202,8 +254,12 @@ static bool flash_buffered_flush(target_flash_s *flash)
 		const uint8_t *src = flash->buf + (aligned_addr - flash->buf_addr_base);
 		const uint32_t length = flash->buf_addr_high - aligned_addr;
 
+		flash_stats_snapshot_s snapshot;
+		flash_stats_begin(&snapshot);
 		for (size_t offset = 0; offset < length; offset += flash->writesize)
 			result &= flash->write(flash, aligned_addr + offset, src + offset, flash->writesize);
+		flash_stats_end(flash, &snapshot, &flash->stats.write_time);
+		flash->stats.bytes_written += length;
 
 		flash->buf_addr_base = UINT32_MAX;
 		flash->buf_addr_low = UINT32_MAX;
@@ -298,6 +354,27 @@ bool target_flash_write(target_s *target, target_addr_t dest, const void *src, s
 	return result;
 }
 
+/*
+ * Reading Flash that's only accessible through a memory-mapped (XIP) window part way through a Flash session
+ * would otherwise see the controller in command mode. Flush anything still pending for the Flash being read,
+ * then have the driver switch the window back on (including any cache flush) once. It stays that way until
+ * the next erase or write, so a verify pass runs at full memory access speed.
+ */
+bool target_flash_map_for_read(target_s *target, const target_addr_t addr, const size_t len)
+{
+	bool result = true; /* Catch false returns with &= */
+	for (target_flash_s *flash = target->flash; flash; flash = flash->next) {
+		if (!flash->map || flash->mapped || addr + len <= flash->start || addr >= flash->start + flash->length)
+			continue;
+		result &= flash_buffered_flush(flash);
+		result &= flash_done(flash);
+		if (result)
+			flash->mapped = flash->map(flash, true);
+		result &= flash->mapped;
+	}
+	return result;
+}
+
 bool target_flash_complete(target_s *target)
 {
 	if (!target->flash_mode)
@@ -312,3 +389,31 @@ bool target_flash_complete(target_s *target)
 	target_exit_flash_mode(target);
 	return result;
 }
+
+static uint32_t flash_stats_rate(const uint32_t bytes, const uint32_t time)
+{
+	if (!time)
+		return 0;
+	return (uint32_t)(((uint64_t)bytes * 1000U) / time / 1024U);
+}
+
+void target_flash_stats_print(target_s *const target)
+{
+	for (const target_flash_s *flash = target->flash; flash; flash = flash->next) {
+		const target_flash_stats_s *const stats = &flash->stats;
+		tc_printf(target, "Flash 0x%08" PRIx32 "+0x%08" PRIx32 ":\n", flash->start, (uint32_t)flash->length);
+		tc_printf(target, "  erase: %" PRIu32 " bytes in %" PRIu32 "ms, %" PRIu32 " KiB/s\n", stats->bytes_erased,
+			stats->erase_time, flash_stats_rate(stats->bytes_erased, stats->erase_time));
+		tc_printf(target, "  write: %" PRIu32 " bytes in %" PRIu32 "ms, %" PRIu32 " KiB/s\n", stats->bytes_written,
+			stats->write_time, flash_stats_rate(stats->bytes_written, stats->write_time));
+		tc_printf(target, "  prepare: %" PRIu32 "ms, done: %" PRIu32 "ms\n", stats->prepare_time, stats->done_time);
+		tc_printf(target, "  link: %" PRIu32 " bytes in %" PRIu32 " transactions, %" PRIu32 " busy polls\n",
+			stats->link.bytes, stats->link.transactions, stats->link.busy_polls);
+	}
+}
+
+void target_flash_stats_reset(target_s *const target)
+{
+	for (target_flash_s *flash = target->flash; flash; flash = flash->next)
+		memset(&flash->stats, 0, sizeof(flash->stats));
+}
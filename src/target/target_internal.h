@@ -48,10 +48,30 @@ struct target_ram {
 
 typedef struct target_flash target_flash_s;
 
+typedef struct target_link_stats {
+	uint32_t bytes;        /* Bytes moved by target memory accesses */
+	uint32_t transactions; /* Number of target memory accesses */
+	uint32_t busy_polls;   /* Progress checks made while waiting on the target */
+} target_link_stats_s;
+
+typedef struct target_flash_stats {
+	/* Time spent in each of the Flash operation steps, in milliseconds */
+	uint32_t prepare_time;
+	uint32_t erase_time;
+	uint32_t write_time;
+	uint32_t done_time;
+	/* Bytes handed to the erase and write handlers */
+	uint32_t bytes_erased;
+	uint32_t bytes_written;
+	/* Link traffic and busy-waiting during the above steps */
+	target_link_stats_s link;
+} target_flash_stats_s;
+
 typedef bool (*flash_prepare_func)(target_flash_s *flash);
 typedef bool (*flash_erase_func)(target_flash_s *flash, target_addr_t addr, size_t len);
 typedef bool (*flash_write_func)(target_flash_s *flash, target_addr_t dest, const void *src, size_t len);
 typedef bool (*flash_done_func)(target_flash_s *flash);
+typedef bool (*flash_map_func)(target_flash_s *flash, bool mapped);
 
 struct target_flash {
 	target_s *t;                 /* Target this flash is attached to */
@@ -61,11 +81,15 @@ struct target_flash {
 	size_t writesize;            /* Write operation size, must be <= blocksize/writebufsize */
 	size_t writebufsize;         /* Size of write buffer, this is calculated and not set in target code */
 	uint8_t erased;              /* Byte erased state */
+	bool range_erase;            /* Erase handler accepts any block aligned range, not just a single block */
 	uint8_t operation;           /* Current Flash operation (none means it's idle/unprepared) */
 	flash_prepare_func prepare;  /* Prepare for flash operations */
 	flash_erase_func erase;      /* Erase a range of flash */
 	flash_write_func write;      /* Write to flash */
 	flash_done_func done;        /* Finish flash operations */
+	flash_map_func map;          /* Switch between command mode and reading through the memory-mapped window */
+	bool mapped;                 /* Memory-mapped window has been made readable part way through Flash mode */
+	target_flash_stats_s stats;  /* Timing and link usage of the operations on this Flash */
 	uint8_t *buf;                /* Buffer for flash operations */
 	target_addr_t buf_addr_base; /* Address of block this buffer is for */
 	target_addr_t buf_addr_low;  /* Address of lowest byte written */
@@ -96,11 +120,14 @@ struct breakwatch {
 	target_breakwatch_e type;
 	target_addr_t addr;
 	size_t size;
+	bool clear_pending;   /* Cleared by GDB, but still set in hardware until the target next resumes */
 	uint32_t reserved[4]; /* For use by the implementing driver */
 };
 
 #define MAX_CMDLINE 81
 
+typedef struct target_read_cache target_read_cache_s;
+
 struct target {
 	target_controller_s *tc;
 
@@ -112,6 +139,8 @@ struct target {
 	/* Memory access functions */
 	void (*mem_read)(target_s *target, void *dest, target_addr_t src, size_t len);
 	void (*mem_write)(target_s *target, target_addr_t dest, const void *src, size_t len);
+	/* Checksum a region on the target itself rather than reading it back */
+	bool (*crc32)(target_s *target, uint32_t *result, target_addr_t base, size_t len);
 
 	/* Register access functions */
 	size_t regs_size;
@@ -141,6 +170,15 @@ struct target {
 	bool (*exit_flash_mode)(target_s *target);
 	bool flash_mode;
 
+	/*
+	 * Read cache for memory and registers, only used between the target halting and being resumed.
+	 * Drivers that keep their own copy of the registers while halted set driver_caches_regs to skip the latter.
+	 */
+	bool read_cache_enabled;
+	bool driver_caches_regs;
+	bool halted;
+	target_read_cache_s *read_cache;
+
 	/* Target-defined options */
 	uint32_t target_options;
 
@@ -162,6 +200,7 @@ struct target {
 	target_addr_t heapinfo[4];
 	target_command_s *commands;
 	bool stdout_redirected;
+	bool stdout_console;
 
 	target_s *next;
 
@@ -179,6 +218,9 @@ struct target {
 	bool attached;
 };
 
+/* Running totals for all target memory traffic, used to attribute link usage to Flash operations */
+extern target_link_stats_s target_link_stats;
+
 void target_print_progress(platform_timeout_s *timeout);
 void target_ram_map_free(target_s *target);
 void target_flash_map_free(target_s *target);
@@ -188,6 +230,14 @@ void target_add_ram(target_s *target, target_addr_t start, uint32_t len);
 void target_add_flash(target_s *target, target_flash_s *flash);
 
 target_flash_s *target_flash_for_addr(target_s *target, uint32_t addr);
+bool target_flash_map_for_read(target_s *target, target_addr_t addr, size_t len);
+void target_flash_stats_print(target_s *target);
+void target_flash_stats_reset(target_s *target);
+
+/* Drop everything in the read cache, must be called whenever target state changes outside the cache's view */
+void target_read_cache_flush(target_s *target);
+/* Apply any breakwatch clears deferred until resume, must be called before running code on the target */
+bool target_breakwatch_commit(target_s *target);
 
 /* Convenience function for MMIO access */
 uint32_t target_mem_read32(target_s *target, uint32_t addr);